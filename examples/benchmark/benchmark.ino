@@ -0,0 +1,3 @@
+// MAX2871 tune-rate benchmark. The sketch lives in benchmark_main.cpp so
+// the PlatformIO envs (bench_uno, bench_mega, bench_feather, bench_native)
+// build exactly the same code; the Arduino IDE compiles it from here too.
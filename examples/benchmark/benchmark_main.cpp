@@ -0,0 +1,89 @@
+/* benchmark_main.cpp
+   (Tune-rate report for the board it runs on, see max2871_benchmark.h)
+
+   Arduino: the driver on ArduinoHAL, report on Serial at 115200 baud,
+   repeated every 10 s. Native ('pio run -e bench_native'): the driver on
+   SmokeHAL, which drops the words, so the rows show CPU cost only.
+
+   (c) 2025 Mark Stanley, GPL-3.0-or-later
+ */
+#if defined(ARDUINO) || defined(MAX2871_BENCHMARK)
+
+#include "max2871.h"
+#include "max2871_benchmark.h"
+
+static constexpr double REF_MHZ = 66.0;
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#include "arduino_hal.h"
+
+static constexpr uint8_t RF_EN   = 5;
+static constexpr uint8_t PIN_LE  = A3;
+static constexpr uint8_t PIN_MUX = A2;
+
+#if defined(ARDUINO_AVR_UNO)
+static const char BOARD[] = "uno";
+#elif defined(ARDUINO_AVR_MEGA2560)
+static const char BOARD[] = "mega";
+#elif defined(ARDUINO_ARCH_RP2040)
+static const char BOARD[] = "feather_rp2040";
+#else
+static const char BOARD[] = "arduino";
+#endif
+
+#if defined(__AVR__)
+static const uint16_t REPS = 16;          // freq2FMN takes milliseconds here
+#else
+static const uint16_t REPS = 256;
+#endif
+
+// The clean-clock wait in begin() is idle time, not driver cost
+class NoDelay : public IDelayProvider {
+public:
+    void delayMs(uint32_t) override {}
+};
+
+static ArduinoHAL hal(PIN_LE, RF_EN, PIN_MUX);
+static NoDelay noDelay;
+static MAX2871 lo(REF_MHZ, hal, noDelay);
+
+static uint32_t clockUs() { return micros(); }
+static void print(const char* text) { Serial.print(text); }
+
+static max2871bench::Harness bench(lo, hal, clockUs, print);
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial && millis() < 3000) {}
+    hal.begin();
+    lo.begin();
+}
+
+void loop() {
+    bench.run(BOARD, REPS);
+    delay(10000);
+}
+
+#else
+#include <chrono>
+#include <cstdio>
+#include "smoke_hal.h"
+
+static uint32_t clockUs() {
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+static void print(const char* text) { fputs(text, stdout); }
+
+int main() {
+    SmokeHAL hal(0);
+    MAX2871 lo(REF_MHZ, hal, hal);
+    lo.begin();
+    max2871bench::Harness bench(lo, hal, clockUs, print);
+    bench.run("native", 4096);
+    return 0;
+}
+#endif
+
+#endif // ARDUINO || MAX2871_BENCHMARK
@@ -0,0 +1,269 @@
+/* max2871_client.cpp
+   (PC-side client for the binary control protocol)
+
+   Talks to a sketch that feeds its serial port through
+   max2871proto::Parser and max2871proto::Handler.
+
+     max2871_client /dev/ttyUSB0 [-b baud] [--ref MHz] tune 2400.0
+     max2871_client /dev/ttyUSB0 list 100 200 300.5
+     max2871_client /dev/ttyUSB0 fmn 0x2E8FFC3A 6
+     max2871_client /dev/ttyUSB0 poke 0x80005F42
+     max2871_client /dev/ttyUSB0 status
+     max2871_client /dev/ttyUSB0 --ref 50 sweep 2400 2500 0.1   (delta register stream)
+     max2871_client /dev/ttyUSB0 bench 1000        (tunes/s over the link)
+
+   Build: make client
+
+   (c) 2025 Mark Stanley, GPL-3.0-or-later
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "max2871.h"
+#include "max2871_image.h"
+#include "max2871_protocol.h"
+#include "max2871_stream.h"
+
+using namespace max2871proto;
+
+struct Port {
+    int fd;
+    int timeoutMs;
+};
+
+static size_t portWrite(const uint8_t* data, size_t len, void* ctx) {
+    Port* p = static_cast<Port*>(ctx);
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = write(p->fd, data + done, len - done);
+        if (n <= 0) break;
+        done += (size_t)n;
+    }
+    return done;
+}
+
+static int portRead(void* ctx) {
+    Port* p = static_cast<Port*>(ctx);
+    struct pollfd pfd = {p->fd, POLLIN, 0};
+    uint8_t c;
+    if (poll(&pfd, 1, p->timeoutMs) <= 0 || read(p->fd, &c, 1) != 1) return -1;
+    return c;
+}
+
+static speed_t baudConstant(long baud) {
+    switch (baud) {
+        case 9600:    return B9600;
+        case 57600:   return B57600;
+        case 115200:  return B115200;
+        case 230400:  return B230400;
+#ifdef B1000000
+        case 1000000: return B1000000;
+#endif
+        default:      return 0;
+    }
+}
+
+static int openPort(const char* path, long baud) {
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        std::perror(path);
+        return -1;
+    }
+    struct termios t;
+    tcgetattr(fd, &t);
+    cfmakeraw(&t);
+    speed_t s = baudConstant(baud);     // checked in main()
+    cfsetispeed(&t, s);
+    cfsetospeed(&t, s);
+    tcsetattr(fd, TCSANOW, &t);
+    tcflush(fd, TCIOFLUSH);
+    return fd;
+}
+
+// Host copy of the driver: records the words each point writes for the stream encoder
+struct Recorder : public IDelayProvider, public I_MAX2871Transport {
+    uint32_t words[12];
+    uint8_t count = 0;
+    void delayMs(uint32_t) override {}
+    bool readMuxout() override { return false; }
+    void spiWriteRegister(uint32_t value) override {
+        if (count < 12) words[count++] = value;
+    }
+};
+
+// Whole-argument decimal number; atof() would read "abc" as 0
+static bool parseMHz(const char* text, double& value) {
+    char* end;
+    value = std::strtod(text, &end);
+    return end != text && *end == '\0' && std::isfinite(value);
+}
+
+static void usage() {
+    std::fprintf(stderr,
+        "usage: max2871_client PORT [-b baud] [--ref MHz] COMMAND ...\n"
+        "  baud: 9600, 57600, 115200 (default), 230400, 1000000\n"
+        "  tune MHz | list MHz... | fmn FMN DIVA | poke WORD... | status | bench COUNT\n"
+        "  sweep START_MHZ STOP_MHZ STEP_MHZ   (solved here for --ref, default 66)\n");
+}
+
+static int report(bool ok, const Client::Reply& r) {
+    if (!ok) {
+        std::fprintf(stderr, "no reply\n");
+        return 1;
+    }
+    std::printf("status=%u count=%u\n", r.status, r.count);
+    return r.status == STATUS_OK ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        usage();
+        return 2;
+    }
+    const char* path = argv[1];
+    long baud = 115200;
+    double refMHz = 66.0;
+    int i = 2;
+    for (; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "-b") == 0) {
+            baud = std::atol(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--ref") == 0) {
+            refMHz = std::atof(argv[i + 1]);
+        } else {
+            break;
+        }
+    }
+    if (!baudConstant(baud)) {
+        std::fprintf(stderr, "-b %ld: unsupported baud rate\n", baud);
+        usage();
+        return 2;
+    }
+    if (!max2871image::validReference(refMHz)) {
+        std::fprintf(stderr, "--ref must be 10-210 MHz\n");
+        return 2;
+    }
+    if (i >= argc) {
+        usage();
+        return 2;
+    }
+
+    Port port = {openPort(path, baud), 1000};
+    if (port.fd < 0) return 1;
+    Client client(portWrite, portRead, &port);
+    Client::Reply reply;
+    const char* cmd = argv[i++];
+    int rc = 2;
+
+    if (std::strcmp(cmd, "tune") == 0 && i < argc) {
+        rc = report(client.tune(std::atof(argv[i]), reply), reply);
+    } else if (std::strcmp(cmd, "list") == 0 && i < argc) {
+        // Split long lists into frames that fit the device buffer
+        std::vector<double> freqs;
+        for (; i < argc; ++i) freqs.push_back(std::atof(argv[i]));
+        const size_t perFrame = MAX2871_PROTO_MAX_PAYLOAD / 4;
+        rc = 0;
+        for (size_t k = 0; k < freqs.size() && rc == 0; k += perFrame) {
+            uint8_t n = (uint8_t)std::min(perFrame, freqs.size() - k);
+            rc = report(client.tuneList(&freqs[k], n, reply), reply);
+        }
+    } else if (std::strcmp(cmd, "fmn") == 0 && i + 1 < argc) {
+        uint32_t fmn = (uint32_t)std::strtoul(argv[i], nullptr, 0);
+        uint8_t diva = (uint8_t)std::atoi(argv[i + 1]);
+        rc = report(client.tuneFMN(&fmn, &diva, 1, reply), reply);
+    } else if (std::strcmp(cmd, "poke") == 0 && i < argc) {
+        std::vector<uint32_t> words;
+        for (; i < argc; ++i) words.push_back((uint32_t)std::strtoul(argv[i], nullptr, 0));
+        const size_t maxWords = MAX2871_PROTO_MAX_PAYLOAD / 4;
+        if (words.size() > maxWords) {
+            std::fprintf(stderr, "poke: at most %zu words per frame\n", maxWords);
+            close(port.fd);
+            return 2;
+        }
+        rc = report(client.writeRegisters(words.data(), (uint8_t)words.size(), reply), reply);
+    } else if (std::strcmp(cmd, "status") == 0) {
+        bool ok = client.status(reply);
+        rc = report(ok, reply);
+        if (ok) {
+            std::printf("locked=%d fmn=0x%08X diva=%u\n", reply.locked ? 1 : 0,
+                        (unsigned)reply.fmn, reply.diva);
+        }
+    } else if (std::strcmp(cmd, "sweep") == 0 && i + 2 < argc) {
+        // Solve on the PC; the device only replays register deltas
+        const double maxPoints = 65535;     // Reply::count is 16 bits
+        double start, stop, step;
+        if (!parseMHz(argv[i], start) || !parseMHz(argv[i + 1], stop) || !parseMHz(argv[i + 2], step) ||
+            step <= 0 || stop < start) {
+            std::fprintf(stderr, "sweep: need numeric START <= STOP and STEP > 0\n");
+            close(port.fd);
+            return 2;
+        }
+        if (!max2871image::validN(refMHz, start) || !max2871image::validN(refMHz, stop)) {
+            std::fprintf(stderr, "sweep: %.6f-%.6f MHz is out of range at a %.3f MHz reference\n",
+                         start, stop, refMHz);
+            close(port.fd);
+            return 2;
+        }
+        double span = (stop - start) / step;
+        if (span >= maxPoints) {
+            std::fprintf(stderr, "sweep: more than %.0f points\n", maxPoints);
+            close(port.fd);
+            return 2;
+        }
+        unsigned long points = (unsigned long)(span + 1e-9) + 1;     // last point <= STOP
+        for (unsigned long k = 0; k < points; ++k) {
+            if (!max2871image::validN(refMHz, start + k * step)) {
+                std::fprintf(stderr, "sweep: %.6f MHz is out of range at a %.3f MHz reference\n",
+                             start + k * step, refMHz);
+                close(port.fd);
+                return 2;
+            }
+        }
+        Recorder rec;
+        MAX2871 host(refMHz, rec, rec);
+        host.begin();
+        host.setFrequency(start);
+        std::vector<uint8_t> buf(32 + points * 16);
+        max2871stream::Encoder enc(buf.data(), buf.size());
+        bool ok = enc.keyframe(host.Curr.Reg);
+        for (unsigned long k = 1; k < points && ok; ++k) {
+            rec.count = 0;
+            host.setFrequency(start + k * step);
+            ok = enc.point(rec.words, rec.count);
+        }
+        ok = ok && enc.finish();
+        if (!ok) {
+            std::fprintf(stderr, "encode failed\n");
+            rc = 1;
+        } else {
+            std::printf("%lu points, %zu bytes (%.2f bytes/point)\n", points, enc.size(),
+                        (double)enc.size() / points);
+            rc = report(client.stream(buf.data(), enc.size(), reply), reply);
+        }
+    } else if (std::strcmp(cmd, "bench") == 0 && i < argc) {
+        // Round-trip TUNE rate, including the device-side solve and SPI writes
+        long count = std::atol(argv[i]);
+        auto t0 = std::chrono::steady_clock::now();
+        rc = 0;
+        for (long k = 0; k < count && rc == 0; ++k) {
+            if (!client.tune(100.0 + (k % 5000), reply) || reply.status != STATUS_OK) rc = 1;
+        }
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::printf("%ld tunes in %.3f s = %.1f tunes/s @ %ld baud\n", count, s, count / s, baud);
+    } else {
+        usage();
+    }
+
+    close(port.fd);
+    return rc;
+}
@@ -0,0 +1,191 @@
+/* bench_simulavr.cpp
+   (Cycle-accurate AVR benchmark, run under simulavr)
+
+   Built by the `uno_simulavr` PlatformIO environment and executed by
+   run_simulavr.sh. Each operation is timed with Timer1 running at the
+   CPU clock (prescaler 1) plus a software overflow count, so the reported
+   numbers are exact 16 MHz cycles. Stack usage is measured by painting
+   the free RAM before each operation and scanning it afterwards.
+
+   Output goes to the simulavr pipe register at BENCH_PIPE_ADDR, the exit
+   code to BENCH_EXIT_ADDR. Both are unused data addresses on the
+   ATmega328P, so the same firmware is harmless on real hardware.
+
+   (c) 2025 Mark Stanley, GPL-3.0-or-later
+ */
+#if defined(MAX2871_SIMULAVR_BENCH) && defined(__AVR__)
+
+#include <Arduino.h>
+#include <avr/interrupt.h>
+#include "max2871.h"
+#include "arduino_hal.h"
+#include "board_transport.h"
+
+// simulavr: -W 0x20,- -e 0x21
+#define BENCH_PIPE_ADDR 0x20
+#define BENCH_EXIT_ADDR 0x21
+
+static constexpr uint8_t PIN_LE  = A3;
+static constexpr uint8_t PIN_MUX = A2;
+static constexpr double  REF_MHZ = 66.0;
+static constexpr uint8_t PAINT   = 0xA5;
+
+// The clean-clock 20 ms wait is pure idle time, not CPU cost.
+// Skip it so the simulation measures only the work done by the driver.
+class NoDelay : public IDelayProvider {
+public:
+    void delayMs(uint32_t) override {}
+};
+
+// Same wiring as compile-time traits: A3 = PC3, A2 = PC2 (PORTC @ 0x28)
+struct BenchBoard {
+    typedef board::AvrPin<0x28, 3> LE;
+    typedef board::NoPin CE;
+    typedef board::AvrPin<0x28, 2> MUX;
+    static constexpr uint32_t SPI_MAX_HZ = F_CPU / 2;
+};
+
+static ArduinoHAL hal(PIN_LE, 0xFF, PIN_MUX);
+static BoardTransport<BenchBoard> fastHal;
+static NoDelay noDelay;
+static MAX2871 lo(REF_MHZ, hal, noDelay);
+static MAX2871 fastLo(REF_MHZ, fastHal, noDelay);
+
+// ---- Output over the simulavr pipe register ----
+
+static void pipePut(char c) {
+    *(volatile uint8_t*)BENCH_PIPE_ADDR = (uint8_t)c;
+}
+
+static void pipePrint(const char* s) {
+    while (*s) pipePut(*s++);
+}
+
+static void pipePrintU32(uint32_t v) {
+    char buf[11];
+    uint8_t i = 0;
+    do {
+        buf[i++] = '0' + (v % 10);
+        v /= 10;
+    } while (v);
+    while (i) pipePut(buf[--i]);
+}
+
+// ---- Cycle counter: Timer1 @ F_CPU with overflow extension ----
+
+static volatile uint16_t t1Overflows;
+
+ISR(TIMER1_OVF_vect) {
+    t1Overflows++;
+}
+
+static void cyclesBegin() {
+    TIMSK0 = 0;                 // Stop the millis() tick from stealing cycles
+    TCCR1A = 0;
+    TCCR1B = 0;
+    TCNT1  = 0;
+    TIFR1  = _BV(TOV1);
+    TIMSK1 = _BV(TOIE1);
+    t1Overflows = 0;
+    TCCR1B = _BV(CS10);         // Prescaler 1 => one count per CPU cycle
+}
+
+static uint32_t cyclesNow() {
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t lo16 = TCNT1;
+    uint16_t hi16 = t1Overflows;
+    if ((TIFR1 & _BV(TOV1)) && lo16 < 0x8000) hi16++;   // Overflow not yet serviced
+    SREG = sreg;
+    return ((uint32_t)hi16 << 16) | lo16;
+}
+
+// ---- Stack high-water mark by RAM painting ----
+
+extern uint8_t __heap_start;
+extern void* __brkval;
+
+static uint8_t* stackFloor() {
+    return __brkval ? (uint8_t*)__brkval : &__heap_start;
+}
+
+static void stackPaint() {
+    uint8_t marker;
+    for (uint8_t* p = stackFloor(); p < &marker - 16; ++p) *p = PAINT;
+}
+
+static uint16_t stackUsed(uint8_t* top) {
+    uint8_t* p = stackFloor();
+    while (p < top && *p == PAINT) ++p;
+    return (uint16_t)(top - p);
+}
+
+// ---- Measurement ----
+
+typedef void (*BenchOp)();
+
+static uint32_t overhead;
+
+static void measure(const char* name, BenchOp op) {
+    uint8_t top;
+    stackPaint();
+    uint32_t t0 = cyclesNow();
+    op();
+    uint32_t t1 = cyclesNow();
+    uint32_t cycles = t1 - t0 - overhead;
+    pipePrint("op=");
+    pipePrint(name);
+    pipePrint(" cycles=");
+    pipePrintU32(cycles);
+    pipePrint(" us=");
+    pipePrintU32(cycles / (F_CPU / 1000000UL));
+    pipePrint(" stack=");
+    pipePrintU32(stackUsed(&top));
+    pipePrint("\n");
+}
+
+static void opEmpty()           {}
+static void opBegin()           { lo.begin(); }
+static void opFreq2FMN()        { lo.freq2FMN(4129.392); }
+static void opSetFreqMath()     { lo.setFrequency(2400.0); }
+static void opSetFreqPacked()   { lo.setFrequency((744UL << 20) | (4092UL << 8) | 58UL, 6); }
+static void opOutputPower()     { lo.outputPower(+2, RF_ALL); }
+static void opSpiWriteRegister(){ hal.spiWriteRegister(0x00400005UL); }
+static void opFastSetFreqPacked(){ fastLo.setFrequency((744UL << 20) | (4092UL << 8) | 58UL, 6); }
+static void opFastSpiWrite()    { fastHal.spiWriteRegister(0x00400005UL); }
+static void opDirectSetFreqPacked(){ fastLo.setFrequency((744UL << 20) | (4092UL << 8) | 58UL, 6, fastHal); }
+
+void setup() {
+    hal.begin();
+    fastHal.begin();
+    fastLo.begin();
+    cyclesBegin();
+    sei();
+
+    // Calibrate the cost of the measurement itself
+    overhead = 0;
+    uint32_t t0 = cyclesNow();
+    opEmpty();
+    overhead = cyclesNow() - t0;
+
+    pipePrint("# MAX2871 simulavr benchmark F_CPU=");
+    pipePrintU32(F_CPU);
+    pipePrint("\n");
+    measure("begin",             opBegin);
+    measure("freq2FMN",          opFreq2FMN);
+    measure("setFrequency",      opSetFreqMath);
+    measure("setFrequencyFMN",   opSetFreqPacked);
+    measure("updateRegisters",   opOutputPower);     // R4 change only
+    measure("spiWriteRegister",  opSpiWriteRegister);
+    // Board-traits transport: compare with the two ArduinoHAL rows above
+    measure("setFrequencyFMN/traits",  opFastSetFreqPacked);
+    measure("spiWriteRegister/traits", opFastSpiWrite);
+    measure("setFrequencyFMN/direct",  opDirectSetFreqPacked);  // no vtable
+    pipePrint("# done\n");
+
+    *(volatile uint8_t*)BENCH_EXIT_ADDR = 0;     // Ends the simulation
+}
+
+void loop() {}
+
+#endif // MAX2871_SIMULAVR_BENCH && __AVR__
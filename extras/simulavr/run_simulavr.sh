@@ -0,0 +1,40 @@
+#!/bin/sh
+# run_simulavr.sh
+#   Build the `uno_simulavr` firmware and run it under simulavr.
+#   Prints exact cycle counts per operation followed by the flash
+#   footprint of each benchmarked function and the static RAM totals.
+#
+#   Usage: extras/simulavr/run_simulavr.sh [output-file]
+#
+# (c) 2025 Mark Stanley, GPL-3.0-or-later
+set -eu
+
+ENV=uno_simulavr
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+ELF="$ROOT/.pio/build/$ENV/firmware.elf"
+OUT=${1:-"$ROOT/bench_output.txt"}
+
+for tool in pio simulavr avr-nm avr-size; do
+    command -v "$tool" >/dev/null 2>&1 || {
+        echo "ERROR: $tool not found on PATH." >&2
+        exit 1
+    }
+done
+
+(cd "$ROOT" && pio run -e "$ENV")
+
+{
+    echo "## Cycles (ATmega328P @ 16 MHz, simulavr)"
+    # 0x20 = output pipe, 0x21 = exit register; 10 s of simulated time is a safety net
+    simulavr -d atmega328 -F 16000000 -f "$ELF" -W 0x20,- -e 0x21 -m 10000000000
+
+    echo
+    echo "## Flash per function (bytes)"
+    avr-nm --size-sort --print-size --radix=d -C "$ELF" \
+        | grep -E 'MAX2871::(freq2FMN|setFrequency|updateRegisters|setRegisterField|reset)|ArduinoHAL::spiWriteRegister' \
+        | awk '{ printf "%-6d %s\n", $2 + 0, substr($0, index($0, $4)) }'
+
+    echo
+    echo "## Image totals"
+    avr-size -A "$ELF" | grep -E '^\.(text|data|bss)'
+} | tee "$OUT"
@@ -0,0 +1,362 @@
+/* max2871_sweep.cpp
+   (Exhaustive host-side accuracy and latency sweep)
+
+   Solves every point of the tuning range at a fixed step, split across
+   all cores, and reports the worst-case error and solver time per band
+   and per DIVA. A compact error map follows the tables. Any solver in
+   the table below can be swept, and --compare runs a second solver on
+   the same points so a faster solver can be checked point-for-point
+   against the brute-force reference before it is merged.
+
+   Build and run:  make sweep ARGS="--step-khz 1"
+
+   (c) 2025 Mark Stanley, GPL-3.0-or-later
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "max2871.h"
+#include "max2871_image.h"
+
+typedef MAX2871::fmnSolution Solution;
+typedef void (*SolverFn)(double Fpfd, double targetMHz, Solution& sol);
+
+// ---- Solvers ----
+
+// The driver's brute-force search (what ships in freq2FMN)
+static void solveReference(double Fpfd, double targetMHz, Solution& sol) {
+    MAX2871::solveFMN(Fpfd, static_cast<float>(targetMHz), sol);
+}
+
+// Best rational approximation of the fractional part with M <= 4095,
+// found by walking the continued fraction (Stern-Brocot) expansion.
+static void solveRational(double Fpfd, double targetMHz, Solution& sol) {
+    double Fvco = targetMHz;
+    sol.DIVA = 0;
+    while (Fvco < 3000.0) {
+        Fvco *= 2;
+        sol.DIVA += 1;
+    }
+    double NdotF = Fvco / Fpfd;
+    uint32_t N = static_cast<uint32_t>(NdotF);
+    double x = NdotF - N;
+
+    // Convergents p/q of x, bounded by q <= 4095
+    uint32_t p0 = 0, q0 = 1, p1 = 1, q1 = 0;
+    double r = x;
+    for (int i = 0; i < 32; ++i) {
+        double a = std::floor(r);
+        uint32_t ai = static_cast<uint32_t>(std::min(a, 4096.0));   // Anything larger overflows M
+        uint32_t p2 = ai * p1 + p0;
+        uint32_t q2 = ai * q1 + q0;
+        if (q2 > 4095) {
+            // Best semiconvergent that still fits
+            uint32_t k = (4095 - q0) / q1;
+            uint32_t ps = k * p1 + p0, qs = k * q1 + q0;
+            if (std::fabs(x - double(ps) / qs) < std::fabs(x - double(p1) / q1)) {
+                p1 = ps;
+                q1 = qs;
+            }
+            break;
+        }
+        p0 = p1; q0 = q1; p1 = p2; q1 = q2;
+        if (r - a < 1e-12) break;
+        r = 1.0 / (r - a);
+    }
+    if (q1 < 2) {           // M must be at least 2
+        p1 *= 2;
+        q1 = 2;
+    }
+    if (p1 >= q1) {         // Rounded up to the next integer
+        N += 1;
+        p1 = 0;
+    }
+    sol.N = static_cast<uint16_t>(N);
+    sol.Frac = static_cast<uint16_t>(p1);
+    sol.M = static_cast<uint16_t>(q1);
+}
+
+struct SolverEntry {
+    const char* name;
+    SolverFn fn;
+};
+
+static const SolverEntry solvers[] = {
+    {"reference", solveReference},
+    {"rational",  solveRational},
+};
+
+static SolverFn findSolver(const char* name) {
+    for (const SolverEntry& s : solvers) {
+        if (std::strcmp(s.name, name) == 0) return s.fn;
+    }
+    return nullptr;
+}
+
+// ---- Statistics ----
+
+static constexpr int NUM_DIVA = 8;
+static constexpr int MAP_COLS = 64;
+
+struct Stat {
+    uint64_t points = 0;
+    double worstErrHz = 0.0;
+    double worstAtMHz = 0.0;
+    double sumErrHz = 0.0;
+    double worstNs = 0.0;
+    double sumNs = 0.0;
+    uint64_t invalid = 0;           // dividers the chip cannot take (N wrapped, Frac >= M...)
+    uint64_t mismatches = 0;        // compare mode: points where alt is worse
+    double worstRegressHz = 0.0;    // compare mode: alt error - reference error
+
+    void add(double freq, double errHz, double ns) {
+        points++;
+        sumErrHz += errHz;
+        sumNs += ns;
+        if (errHz > worstErrHz) {
+            worstErrHz = errHz;
+            worstAtMHz = freq;
+        }
+        worstNs = std::max(worstNs, ns);
+    }
+
+    void merge(const Stat& o) {
+        if (o.worstErrHz > worstErrHz) {
+            worstErrHz = o.worstErrHz;
+            worstAtMHz = o.worstAtMHz;
+        }
+        points += o.points;
+        invalid += o.invalid;
+        sumErrHz += o.sumErrHz;
+        sumNs += o.sumNs;
+        worstNs = std::max(worstNs, o.worstNs);
+        mismatches += o.mismatches;
+        worstRegressHz = std::max(worstRegressHz, o.worstRegressHz);
+    }
+};
+
+struct Options {
+    double refMHz = 66.0;
+    double startMHz = 23.5;
+    double stopMHz = 6000.0;
+    double stepKHz = 1000.0;
+    double bandMHz = 250.0;
+    double limitHz = 2000.0;        // Same tolerance as test_max2871.cpp
+    unsigned threads = 0;
+    const char* solver = "reference";
+    const char* compare = nullptr;
+};
+
+struct Worker {
+    std::vector<Stat> bands;
+    Stat diva[NUM_DIVA];
+    std::vector<double> map;        // worst error per map cell
+};
+
+static double outputMHz(double Fpfd, const Solution& s) {
+    return Fpfd * (s.N + double(s.Frac) / s.M) / double(1u << s.DIVA);
+}
+
+// DIVA the solvers pick for 'freqMHz' (VCO doubled into 3000-6000 MHz)
+static int divaFor(double freqMHz) {
+    int diva = 0;
+    for (; freqMHz < 3000.0; freqMHz *= 2) diva++;
+    return diva;
+}
+
+// Every point of start..stop keeps N = VCO / reference under 256. Across an
+// octave boundary the VCO sweeps up to 6000 MHz.
+static bool reachable(double refMHz, double startMHz, double stopMHz) {
+    if (!max2871image::validN(refMHz, startMHz) || !max2871image::validN(refMHz, stopMHz)) return false;
+    return divaFor(startMHz) == divaFor(stopMHz) || max2871image::validN(refMHz, 6000.0);
+}
+
+static double nowNs() {
+    using namespace std::chrono;
+    return double(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+static void usage() {
+    std::printf("usage: max2871_sweep [--ref MHz] [--start MHz] [--stop MHz] [--step-khz kHz]\n"
+                "                     [--band MHz] [--limit-hz Hz] [--threads N]\n"
+                "                     [--solver NAME] [--compare NAME]\n"
+                "ranges: ref 10-210 MHz, start/stop 23.5-6000 MHz, step > 0,\n"
+                "        VCO / ref under 256 (N is 8 bits) over the whole range\n"
+                "solvers:");
+    for (const SolverEntry& s : solvers) std::printf(" %s", s.name);
+    std::printf("\n");
+}
+
+static bool parseArgs(int argc, char** argv, Options& o) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (i + 1 >= argc) return false;
+        const char* v = argv[++i];
+        if      (a == "--ref")       o.refMHz = std::atof(v);
+        else if (a == "--start")     o.startMHz = std::atof(v);
+        else if (a == "--stop")      o.stopMHz = std::atof(v);
+        else if (a == "--step-khz")  o.stepKHz = std::atof(v);
+        else if (a == "--band")      o.bandMHz = std::atof(v);
+        else if (a == "--limit-hz")  o.limitHz = std::atof(v);
+        else if (a == "--threads")   o.threads = static_cast<unsigned>(std::atoi(v));
+        else if (a == "--solver")    o.solver = v;
+        else if (a == "--compare")   o.compare = v;
+        else return false;
+    }
+    // Outside 23.5-6000 MHz DIVA overflows its 3 bits (and 0 MHz never reaches the VCO range)
+    return max2871image::validReference(o.refMHz) && max2871image::validFrequency(o.startMHz) &&
+           max2871image::validFrequency(o.stopMHz) && o.stopMHz >= o.startMHz &&
+           reachable(o.refMHz, o.startMHz, o.stopMHz) && o.stepKHz > 0 && o.bandMHz > 0;
+}
+
+// Map glyphs by worst error in the cell
+static char glyph(double errHz, double limitHz) {
+    if (errHz < 1.0)      return '.';
+    if (errHz < 10.0)     return ':';
+    if (errHz < 100.0)    return 'o';
+    if (errHz < limitHz)  return 'O';
+    return '#';
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) {
+        usage();
+        return 2;
+    }
+    SolverFn solve = findSolver(opt.solver);
+    SolverFn alt = opt.compare ? findSolver(opt.compare) : nullptr;
+    if (!solve || (opt.compare && !alt)) {
+        usage();
+        return 2;
+    }
+
+    const double Fpfd = opt.refMHz;     // R = 1, as in freq2FMN()
+    const double stepMHz = opt.stepKHz / 1000.0;
+    const uint64_t numPoints = static_cast<uint64_t>((opt.stopMHz - opt.startMHz) / stepMHz + 1e-9) + 1;
+    const size_t numBands = static_cast<size_t>((opt.stopMHz - opt.startMHz) / opt.bandMHz) + 1;
+    unsigned numThreads = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<Worker> workers(numThreads);
+    std::vector<std::thread> pool;
+    std::atomic<uint64_t> next(0);
+    const uint64_t chunk = 4096;
+
+    double t0 = nowNs();
+    for (unsigned t = 0; t < numThreads; ++t) {
+        pool.emplace_back([&, t]() {
+            Worker& w = workers[t];
+            w.bands.assign(numBands, Stat());
+            w.map.assign(numBands * MAP_COLS, 0.0);
+            for (;;) {
+                uint64_t begin = next.fetch_add(chunk);
+                if (begin >= numPoints) break;
+                uint64_t end = std::min(numPoints, begin + chunk);
+                for (uint64_t i = begin; i < end; ++i) {
+                    double f = opt.startMHz + double(i) * stepMHz;
+                    Solution s;
+                    double a = nowNs();
+                    solve(Fpfd, f, s);
+                    double ns = nowNs() - a;
+                    double errHz = std::fabs(outputMHz(Fpfd, s) - f) * 1e6;
+                    bool valid = MAX2871::validSolution(s);
+                    if (!valid) errHz = HUGE_VAL;       // never trust the error of a word the chip cannot take
+
+                    size_t band = static_cast<size_t>((f - opt.startMHz) / opt.bandMHz);
+                    size_t col = static_cast<size_t>(std::fmod(f - opt.startMHz, opt.bandMHz) / opt.bandMHz * MAP_COLS);
+                    w.bands[band].add(f, errHz, ns);
+                    if (!valid) w.bands[band].invalid++;
+                    w.diva[s.DIVA].add(f, errHz, ns);
+                    double& cell = w.map[band * MAP_COLS + std::min(col, size_t(MAP_COLS - 1))];
+                    cell = std::max(cell, errHz);
+
+                    if (alt) {
+                        Solution r;
+                        alt(Fpfd, f, r);
+                        double altErrHz = MAX2871::validSolution(r) ? std::fabs(outputMHz(Fpfd, r) - f) * 1e6
+                                                                    : HUGE_VAL;
+                        if (altErrHz > errHz) {
+                            w.bands[band].mismatches++;
+                            w.bands[band].worstRegressHz = std::max(w.bands[band].worstRegressHz, altErrHz - errHz);
+                        }
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread& th : pool) th.join();
+    double wallMs = (nowNs() - t0) / 1e6;
+
+    // ---- Merge ----
+    std::vector<Stat> bands(numBands);
+    Stat diva[NUM_DIVA];
+    Stat total;
+    std::vector<double> map(numBands * MAP_COLS, 0.0);
+    for (const Worker& w : workers) {
+        for (size_t b = 0; b < numBands; ++b) bands[b].merge(w.bands[b]);
+        for (int d = 0; d < NUM_DIVA; ++d) diva[d].merge(w.diva[d]);
+        for (size_t c = 0; c < map.size(); ++c) map[c] = std::max(map[c], w.map[c]);
+    }
+    for (const Stat& b : bands) total.merge(b);
+
+    // ---- Report ----
+    std::printf("# MAX2871 sweep  solver=%s  ref=%.3f MHz  %.3f..%.3f MHz  step=%.3f kHz  points=%llu  threads=%u  wall=%.0f ms\n",
+                opt.solver, opt.refMHz, opt.startMHz, opt.stopMHz, opt.stepKHz,
+                (unsigned long long)numPoints, numThreads, wallMs);
+    if (alt) std::printf("# compare=%s (counts points where it is less accurate than %s)\n", opt.compare, opt.solver);
+
+    std::printf("\n%-19s %10s %12s %12s %10s %10s", "band MHz", "points", "worst Hz", "@ MHz", "mean ns", "worst ns");
+    if (alt) std::printf(" %10s %12s", "worse", "regress Hz");
+    std::printf("\n");
+    for (size_t b = 0; b < numBands; ++b) {
+        const Stat& s = bands[b];
+        if (!s.points) continue;
+        double lo = opt.startMHz + b * opt.bandMHz;
+        std::printf("%8.1f..%-9.1f %10llu %12.3f %12.6f %10.0f %10.0f",
+                    lo, std::min(lo + opt.bandMHz, opt.stopMHz), (unsigned long long)s.points,
+                    s.worstErrHz, s.worstAtMHz, s.sumNs / s.points, s.worstNs);
+        if (alt) std::printf(" %10llu %12.3f", (unsigned long long)s.mismatches, s.worstRegressHz);
+        std::printf("\n");
+    }
+
+    std::printf("\n%-19s %10s %12s %12s %10s %10s\n", "DIVA", "points", "worst Hz", "@ MHz", "mean ns", "worst ns");
+    for (int d = 0; d < NUM_DIVA; ++d) {
+        const Stat& s = diva[d];
+        if (!s.points) continue;
+        std::printf("%-2d (div %-3d)        %10llu %12.3f %12.6f %10.0f %10.0f\n",
+                    d, 1 << d, (unsigned long long)s.points, s.worstErrHz, s.worstAtMHz,
+                    s.sumNs / s.points, s.worstNs);
+    }
+
+    std::printf("\n# error map: one row per band, %d cells per row\n", MAP_COLS);
+    std::printf("#   '.' < 1 Hz  ':' < 10 Hz  'o' < 100 Hz  'O' < %.0f Hz  '#' >= %.0f Hz\n", opt.limitHz, opt.limitHz);
+    for (size_t b = 0; b < numBands; ++b) {
+        if (!bands[b].points) continue;
+        char row[MAP_COLS + 1];
+        for (int c = 0; c < MAP_COLS; ++c) row[c] = glyph(map[b * MAP_COLS + c], opt.limitHz);
+        row[MAP_COLS] = '\0';
+        std::printf("%8.1f |%s|\n", opt.startMHz + b * opt.bandMHz, row);
+    }
+
+    std::printf("\nTOTAL worst=%.3f Hz @ %.6f MHz  mean=%.3f Hz  mean solve=%.0f ns  limit=%.0f Hz  invalid=%llu  %s\n",
+                total.worstErrHz, total.worstAtMHz, total.sumErrHz / total.points,
+                total.sumNs / total.points, opt.limitHz, (unsigned long long)total.invalid,
+                total.worstErrHz < opt.limitHz && !total.invalid ? "PASS" : "FAIL");
+    if (alt) {
+        std::printf("COMPARE %s worse than %s at %llu points, worst regression %.3f Hz  %s\n",
+                    opt.compare, opt.solver, (unsigned long long)total.mismatches,
+                    total.worstRegressHz, total.mismatches ? "FAIL" : "PASS");
+    }
+    bool ok = total.worstErrHz < opt.limitHz && !total.invalid && (!alt || total.mismatches == 0);
+    return ok ? 0 : 1;
+}
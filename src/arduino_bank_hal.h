@@ -0,0 +1,72 @@
+/* arduino_bank_hal.h
+   (Several MAX2871s sharing DATA/CLK, one LE per chip)
+
+   Transport for MAX2871Bank. The word is shifted once with every LE low;
+   the chips' shift registers all hold it until CLK moves again, so raising
+   the selected LE lines one after another latches the same word into each.
+
+   (c) 2025 Mark Stanley, GPL-3.0-or-later
+ */
+
+#ifndef ARDUINO_BANK_HAL_H
+#define ARDUINO_BANK_HAL_H
+
+#include <Arduino.h>
+#include <SPI.h>
+#include "mcu_hal.h"
+#include "max2871_bank.h"
+
+class ArduinoBankHAL : public IDelayProvider, public I_MAX2871BankTransport {
+public:
+    static constexpr uint8_t MAX_CHIPS = 8;
+
+    // lePins/muxPins: one entry per chip. Chips may share a MUXOUT pin; 0xFF = none.
+    ArduinoBankHAL(const uint8_t* lePins, const uint8_t* muxPins, uint8_t count) {
+        _count = count < MAX_CHIPS ? count : MAX_CHIPS;
+        for (uint8_t i = 0; i < _count; ++i) {
+            _le[i] = lePins[i];
+            _mux[i] = muxPins ? muxPins[i] : 0xFF;
+        }
+    }
+
+    void begin() {
+        for (uint8_t i = 0; i < _count; ++i) {
+            ::pinMode(_le[i], OUTPUT);
+            ::digitalWrite(_le[i], LOW);
+            if (_mux[i] != 0xFF) ::pinMode(_mux[i], INPUT);
+        }
+        SPI.begin();
+    }
+
+    void setSpiClockHz(uint32_t hz) { _spiHz = hz; }
+
+    // Timing
+    void delayMs(uint32_t ms) override { ::delay(ms); }
+
+    // MAX2871 helpers
+    void spiWriteRegister(uint32_t value, uint8_t leMask) override {
+        SPI.beginTransaction(SPISettings(_spiHz, MSBFIRST, SPI_MODE0));
+        SPI.transfer16((value >> 16) & 0xFFFF);
+        SPI.transfer16(value & 0xFFFF);
+        for (uint8_t i = 0; i < _count; ++i) {
+            if (leMask & (1 << i)) ::digitalWrite(_le[i], HIGH);
+        }
+        for (uint8_t i = 0; i < _count; ++i) {
+            if (leMask & (1 << i)) ::digitalWrite(_le[i], LOW);
+        }
+        SPI.endTransaction();
+    }
+
+    bool readMuxout(uint8_t chip) override {
+        if (chip >= _count || _mux[chip] == 0xFF) return false;
+        return ::digitalRead(_mux[chip]) == HIGH;
+    }
+
+private:
+    uint8_t _le[MAX_CHIPS];
+    uint8_t _mux[MAX_CHIPS];
+    uint8_t _count;
+    uint32_t _spiHz = 8000000UL;    // Default: Arduino Uno max = 8 MHz
+};
+
+#endif // ARDUINO_BANK_HAL_H
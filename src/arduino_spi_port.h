@@ -0,0 +1,49 @@
+/* arduino_spi_port.h
+   (I_SpiPort on the Arduino SPI library)
+
+   Physical side of SpiBusManager: a session is one beginTransaction /
+   endTransaction pair, selects and MUXOUT are plain digital pins.
+
+   (c) 2025 Mark Stanley, GPL-3.0-or-later
+ */
+
+#ifndef ARDUINO_SPI_PORT_H
+#define ARDUINO_SPI_PORT_H
+
+#include <Arduino.h>
+#include <SPI.h>
+#include "spi_bus.h"
+
+class ArduinoSpiPort : public I_SpiPort {
+public:
+    void begin() { SPI.begin(); }
+
+    void beginSession(uint32_t clockHz, uint8_t mode) override {
+        switch (mode & 3) {     // SPI_MODEx is an enum on some cores, not a number
+            case 1:  SPI.beginTransaction(SPISettings(clockHz, MSBFIRST, SPI_MODE1)); break;
+            case 2:  SPI.beginTransaction(SPISettings(clockHz, MSBFIRST, SPI_MODE2)); break;
+            case 3:  SPI.beginTransaction(SPISettings(clockHz, MSBFIRST, SPI_MODE3)); break;
+            default: SPI.beginTransaction(SPISettings(clockHz, MSBFIRST, SPI_MODE0)); break;
+        }
+    }
+
+    void transfer(const uint8_t* tx, uint8_t* rx, uint8_t len) override {
+        for (uint8_t i = 0; i < len; ++i) {
+            uint8_t in = SPI.transfer(tx[i]);
+            if (rx) rx[i] = in;
+        }
+    }
+
+    void endSession() override { SPI.endTransaction(); }
+
+    void writePin(uint8_t pin, bool high) override { ::digitalWrite(pin, high ? HIGH : LOW); }
+
+    void setupSelect(uint8_t pin, bool idleHigh) override {
+        ::digitalWrite(pin, idleHigh ? HIGH : LOW);
+        ::pinMode(pin, OUTPUT);
+    }
+
+    bool readPin(uint8_t pin) override { return ::digitalRead(pin) == HIGH; }
+};
+
+#endif // ARDUINO_SPI_PORT_H
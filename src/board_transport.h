@@ -0,0 +1,164 @@
+/* board_transport.h
+   (Compile-time board traits for the MAX2871 transport)
+
+   ArduinoHAL looks its pins up at run time, converts the SPI clock from a
+   member on every transaction and toggles LE through ::digitalWrite. When
+   the wiring is fixed at build time all of that can be folded away:
+
+     struct MyBoard {
+         typedef board::AvrPin<0x2B, 3> LE;     // D3 = PD3 (PORTD @ 0x2B)
+         typedef board::NoPin           CE;     // tied high
+         typedef board::AvrPin<0x28, 0> MUX;    // A0 = PC0 (PORTC @ 0x28)
+         static constexpr uint32_t SPI_MAX_HZ = F_CPU / 2;
+     };
+     static BoardTransport<MyBoard> hal;
+     static MAX2871 lo(66.0, hal, hal);
+     lo.setFrequency(2400.0, hal);          // direct calls, no vtable
+
+   The SPI clock is the lower of the MCU limit and the MAX2871's 20 MHz,
+   fixed at compile time. LE becomes single-instruction port writes (sbi/cbi
+   on AVR, SIO set/clear on RP2040).
+
+   The class is final, so passing it to the driver's direct write path,
+   setFrequency(..., hal), resolves every transport call at compile time;
+   plain setFrequency() still goes through the I_MAX2871Transport vtable.
+   Either way an update is one SPI transaction with an LE pulse per word.
+   `make bench-avr` prints the ArduinoHAL, /traits and /direct rows side by
+   side for the Uno. On the Feather RP2040 the SPI clock limit goes from
+   8 MHz to 20 MHz.
+
+   (c) 2025 Mark Stanley, GPL-3.0-or-later
+ */
+
+#ifndef BOARD_TRANSPORT_H
+#define BOARD_TRANSPORT_H
+
+#include <Arduino.h>
+#include <SPI.h>
+#include "mcu_hal.h"
+#include "max2871_transport.h"
+#if defined(ARDUINO_ARCH_RP2040)
+  #include <hardware/structs/sio.h>
+#endif
+
+#define MAX2871_SPI_MAX_HZ 20000000UL     // Datasheet fCLK maximum
+
+namespace board {
+
+// Unconnected pin: writes vanish, reads return low
+struct NoPin {
+    static void output() {}
+    static void input() {}
+    static void high() {}
+    static void low() {}
+    static bool read() { return false; }
+};
+
+// Portable fallback for boards without a fast pin driver below
+template <uint8_t Pin>
+struct ArduinoPin {
+    static void output() { ::pinMode(Pin, OUTPUT); }
+    static void input() { ::pinMode(Pin, INPUT); }
+    static void high() { ::digitalWrite(Pin, HIGH); }
+    static void low() { ::digitalWrite(Pin, LOW); }
+    static bool read() { return ::digitalRead(Pin) == HIGH; }
+};
+
+#if defined(__AVR__)
+// 'PortAddr' is the data-space address of PORTx; DDRx and PINx sit just
+// below it on every AVR port. Ports in I/O space compile to sbi/cbi.
+template <uint16_t PortAddr, uint8_t Bit>
+struct AvrPin {
+    static void output() { *(volatile uint8_t*)(PortAddr - 1) |= (uint8_t)(1 << Bit); }
+    static void input() { *(volatile uint8_t*)(PortAddr - 1) &= (uint8_t)~(1 << Bit); }
+    static void high() { *(volatile uint8_t*)(PortAddr) |= (uint8_t)(1 << Bit); }
+    static void low() { *(volatile uint8_t*)(PortAddr) &= (uint8_t)~(1 << Bit); }
+    static bool read() { return (*(volatile uint8_t*)(PortAddr - 2) >> Bit) & 1; }
+};
+#endif
+
+#if defined(ARDUINO_ARCH_RP2040)
+// Single-cycle IO block: atomic set/clear with no read-modify-write
+template <uint8_t Gpio>
+struct Rp2040Pin {
+    static void output() { ::pinMode(Gpio, OUTPUT); }
+    static void input() { ::pinMode(Gpio, INPUT); }
+    static void high() { sio_hw->gpio_set = 1u << Gpio; }
+    static void low() { sio_hw->gpio_clr = 1u << Gpio; }
+    static bool read() { return (sio_hw->gpio_in >> Gpio) & 1u; }
+};
+#endif
+
+} // namespace board
+
+// ---- Boards in this repository ----
+
+#if defined(ARDUINO_AVR_UNO)
+// Spectrum Analyzer RF board on an Uno: LE = D3, MUXOUT = A0, CE tied high
+struct UnoSpectrumAnalyzerBoard {
+    typedef board::AvrPin<0x2B, 3> LE;
+    typedef board::NoPin CE;
+    typedef board::AvrPin<0x28, 0> MUX;
+    static constexpr uint32_t SPI_MAX_HZ = F_CPU / 2;
+};
+#endif
+
+#if defined(ARDUINO_ARCH_RP2040)
+// Same wiring on the Adafruit Feather RP2040 (Arduino pin = GPIO number)
+struct FeatherRP2040Board {
+    typedef board::Rp2040Pin<3> LE;
+    typedef board::NoPin CE;
+    typedef board::Rp2040Pin<26> MUX;               // A0
+    static constexpr uint32_t SPI_MAX_HZ = 62500000UL;   // clk_peri / 2
+};
+#endif
+
+template <class Traits>
+class BoardTransport final : public IDelayProvider, public I_MAX2871Transport {
+public:
+    static constexpr uint32_t SPI_HZ =
+        Traits::SPI_MAX_HZ < MAX2871_SPI_MAX_HZ ? Traits::SPI_MAX_HZ : MAX2871_SPI_MAX_HZ;
+
+    void begin() {
+        Traits::LE::output();
+        Traits::LE::low();
+        Traits::CE::output();
+        Traits::CE::low();                              // keep LO off initially
+        Traits::MUX::input();
+        SPI.begin();
+    }
+
+    void delayMs(uint32_t ms) override { ::delay(ms); }
+
+    void spiWriteRegister(uint32_t value) override {
+        SPI.beginTransaction(SPISettings(SPI_HZ, MSBFIRST, SPI_MODE0));
+        shift(value);
+        SPI.endTransaction();
+    }
+
+    // One SPI transaction per update, one LE pulse per word
+    void spiWriteRegisters(const uint32_t* values, uint8_t count) override {
+        SPI.beginTransaction(SPISettings(SPI_HZ, MSBFIRST, SPI_MODE0));
+        for (uint8_t i = 0; i < count; ++i) shift(values[i]);
+        SPI.endTransaction();
+    }
+
+    void setCEPin(bool enable) {
+        if (enable) Traits::CE::high();
+        else Traits::CE::low();
+    }
+
+    bool readMuxout() override { return Traits::MUX::read(); }
+
+private:
+    // MAX2871 write (MSB first, 32 bits, Mode 0), latched on the LE rising edge
+    static void shift(uint32_t value) {
+        Traits::LE::low();
+        SPI.transfer16((value >> 16) & 0xFFFF);
+        SPI.transfer16(value & 0xFFFF);
+        Traits::LE::high();
+        Traits::LE::low();
+    }
+};
+
+#endif // BOARD_TRANSPORT_H
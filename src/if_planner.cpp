@@ -0,0 +1,189 @@
+#include "if_planner.h"
+#include <math.h>
+
+// ---- Plan options: every IF1 candidate with every injection side ----
+
+uint16_t IfPlanner::optionCount() const {
+    uint16_t ifs = 1;
+    if (_cfg.if1StepMHz > 0 && _cfg.if1MaxMHz > _cfg.if1MinMHz) {
+        ifs += (uint16_t)((_cfg.if1MaxMHz - _cfg.if1MinMHz) / _cfg.if1StepMHz + 1e-9);
+    }
+    return ifs * 8;
+}
+
+void IfPlanner::option(uint16_t index, Option& opt) const {
+    opt.if1MHz = _cfg.if1MinMHz + (index >> 3) * _cfg.if1StepMHz;
+    opt.lo1Side = index & 1;
+    opt.lo2Side = (index >> 1) & 1;
+    opt.lo3Side = (index >> 2) & 1;
+}
+
+double IfPlanner::lo2For(const Option& opt, double if2MHz) {
+    return opt.lo2Side == HIGH_SIDE ? opt.if1MHz + if2MHz : opt.if1MHz - if2MHz;
+}
+
+double IfPlanner::lo3For(const Option& opt, double if2MHz, double if3MHz) {
+    return opt.lo3Side == HIGH_SIDE ? if2MHz + if3MHz : if2MHz - if3MHz;
+}
+
+double IfPlanner::lo1For(const Segment& seg, double rfMHz) {
+    return seg.lo1Side == HIGH_SIDE ? rfMHz + seg.if1MHz : rfMHz - seg.if1MHz;
+}
+
+bool IfPlanner::usable(const Option& opt, double rfMHz) const {
+    double lo1 = opt.lo1Side == HIGH_SIDE ? rfMHz + opt.if1MHz : rfMHz - opt.if1MHz;
+    if (!inRange(lo1) || !inRange(lo2For(opt, _cfg.if2MHz)) ||
+        !inRange(lo3For(opt, _cfg.if2MHz, _cfg.if3MHz))) return false;
+    if (fabs(rfMHz - opt.if1MHz) <= _cfg.guardMHz) return false;    // IF feedthrough
+    if (fabs(lo1 - opt.if1MHz) <= _cfg.guardMHz) return false;      // LO1 leaks into the IF
+    return true;
+}
+
+// DIVA as the MAX2871 solver picks it: double until the VCO is >= 3000 MHz
+uint8_t IfPlanner::outputDivider(double loMHz) {
+    uint8_t diva = 0;
+    while (loMHz < 3000.0 && diva < 7) {
+        loMHz *= 2;
+        diva++;
+    }
+    return diva;
+}
+
+uint32_t IfPlanner::pointCount(double startMHz, double stopMHz, double stepMHz) {
+    if (stopMHz < startMHz) return 0;
+    if (stepMHz <= 0) return 1;
+    return (uint32_t)((stopMHz - startMHz) / stepMHz + 1e-9) + 1;
+}
+
+// ---- Planning ----
+
+/*  One LO2/LO3 setting ('group': IF1 and the LO2/LO3 sides) from point 'i'.
+    LO1 may change sides inside it for free; it keeps a side until that side
+    is unusable. Returns how far the group reaches. With 'out', the LO1 runs
+    are appended as segments.
+ */
+uint32_t IfPlanner::walk(const Option& group, double startMHz, double stepMHz, uint32_t i, uint32_t n,
+                         uint16_t& divChanges, Segment* out, uint8_t& count, uint8_t maxSegments) const {
+    Option opt = group;
+    uint32_t run[2];
+    for (uint8_t side = 0; side < 2; ++side) {
+        opt.lo1Side = side;
+        run[side] = i;
+        while (run[side] < n && usable(opt, startMHz + run[side] * stepMHz)) run[side]++;
+    }
+    opt.lo1Side = run[HIGH_SIDE] > run[LOW_SIDE] ? HIGH_SIDE : LOW_SIDE;
+
+    divChanges = 0;
+    uint8_t lastDiv = 0xFF;
+    uint32_t j = i;
+    while (j < n) {
+        uint32_t end = j;
+        while (end < n && usable(opt, startMHz + end * stepMHz)) {
+            double rf = startMHz + end * stepMHz;
+            uint8_t div = outputDivider(opt.lo1Side == HIGH_SIDE ? rf + opt.if1MHz : rf - opt.if1MHz);
+            if (lastDiv != 0xFF && div != lastDiv) divChanges++;
+            lastDiv = div;
+            end++;
+        }
+        if (end == j) break;
+        if (out) {
+            if (count == maxSegments) return 0;
+            const Segment* prev = count ? &out[count - 1] : nullptr;
+            Segment& seg = out[count++];
+            seg.firstPoint = j;
+            seg.points = end - j;
+            seg.if1MHz = opt.if1MHz;
+            seg.lo1Side = opt.lo1Side;
+            seg.lo2Side = opt.lo2Side;
+            seg.lo3Side = opt.lo3Side;
+            seg.inverted = ((opt.lo1Side + opt.lo2Side + opt.lo3Side) & 1) != 0;
+            seg.lo2MHz = lo2For(opt, _cfg.if2MHz);
+            seg.lo3MHz = lo3For(opt, _cfg.if2MHz, _cfg.if3MHz);
+            seg.retuneLO2 = !prev || prev->lo2MHz != seg.lo2MHz;
+            seg.retuneLO3 = !prev || prev->lo3MHz != seg.lo3MHz;
+        }
+        j = end;
+        opt.lo1Side ^= 1;                               // the current side just ran out
+    }
+    return j;
+}
+
+uint8_t IfPlanner::plan(double startMHz, double stopMHz, double stepMHz,
+                        Segment* out, uint8_t maxSegments) const {
+    const uint32_t n = pointCount(startMHz, stopMHz, stepMHz);
+    const uint16_t groups = optionCount() / 2;
+    const double centre = (_cfg.if1MinMHz + _cfg.if1MaxMHz) / 2;
+    uint8_t count = 0;
+    uint32_t i = 0;
+
+    while (i < n) {
+        int32_t best = -1;
+        uint32_t bestReach = 0;
+        uint8_t bestRetunes = 0;
+        uint16_t bestDivChanges = 0;
+        double bestIf1 = 0;
+        const Segment* prev = count ? &out[count - 1] : nullptr;
+
+        for (uint16_t g = 0; g < groups; ++g) {
+            Option opt;
+            option((uint16_t)(g << 1), opt);
+            uint16_t divChanges;
+            uint8_t unused = 0;
+            uint32_t reach = walk(opt, startMHz, stepMHz, i, n, divChanges, nullptr, unused, 0);
+            if (reach == i) continue;
+            uint8_t retunes = 2;
+            if (prev) {
+                retunes = (prev->lo2MHz != lo2For(opt, _cfg.if2MHz)) +
+                          (prev->lo3MHz != lo3For(opt, _cfg.if2MHz, _cfg.if3MHz));
+            }
+
+            bool better;
+            if (best < 0) better = true;
+            else if (reach != bestReach) better = reach > bestReach;
+            else if (retunes != bestRetunes) better = retunes < bestRetunes;
+            else if (divChanges != bestDivChanges) better = divChanges < bestDivChanges;
+            else better = fabs(opt.if1MHz - centre) < fabs(bestIf1 - centre);
+            if (better) {
+                best = g;
+                bestReach = reach;
+                bestRetunes = retunes;
+                bestDivChanges = divChanges;
+                bestIf1 = opt.if1MHz;
+            }
+        }
+        if (best < 0) return 0;
+
+        Option opt;
+        option((uint16_t)(best << 1), opt);
+        uint16_t divChanges;
+        if (walk(opt, startMHz, stepMHz, i, n, divChanges, out, count, maxSegments) == 0) return 0;
+        i = bestReach;
+    }
+    return count;
+}
+
+uint32_t IfPlanner::retunes(const Segment* seg, uint8_t count) {
+    uint32_t total = 0;
+    for (uint8_t s = 0; s < count; ++s) total += seg[s].retuneLO2 + seg[s].retuneLO3;
+    return total;
+}
+
+// ---- Execution ----
+
+uint32_t IfPlanner::run(const Segment* seg, uint8_t count, double startMHz, double stepMHz,
+                        I_PLLSynthesizer& lo1, I_PLLSynthesizer& lo2, I_PLLSynthesizer& lo3,
+                        PointFn point, void* ctx) const {
+    uint32_t played = 0;
+    for (uint8_t s = 0; s < count; ++s) {
+        if (seg[s].retuneLO3) lo3.setFrequency(seg[s].lo3MHz);
+        if (seg[s].retuneLO2) lo2.setFrequency(seg[s].lo2MHz);
+        for (uint32_t k = 0; k < seg[s].points; ++k) {
+            uint32_t index = seg[s].firstPoint + k;
+            double rf = startMHz + index * stepMHz;
+            lo1.setFrequency(lo1For(seg[s], rf));
+            if (point) point(index, rf, ctx);
+            played++;
+        }
+    }
+    return played;
+}
@@ -0,0 +1,117 @@
+/* if_planner.h
+   (Segment plan for LO1/LO2/LO3 in a triple-conversion sweep)
+
+   In the SpecAnn chain RF is mixed by LO1 to IF1, by LO2 to IF2 and by LO3
+   to the final IF3:
+
+     LO1 = RF  + IF1 (high side)  or  RF  - IF1 (low side)
+     LO2 = IF1 + IF2              or  IF1 - IF2
+     LO3 = IF2 + IF3              or  IF2 - IF3
+
+   IF2 and IF3 are fixed by their filters; IF1 may sit anywhere in the first
+   IF filter's passband. A sweep only has to move LO1. LO2 and LO3 change
+   when a point can no longer use the current plan, because an LO would
+   leave the synthesizer range, RF would come within 'guardMHz' of IF1 (IF
+   feedthrough), or LO1 would come within it of IF1 (LO leakage into the IF).
+
+   LO1 switching sides costs nothing beyond its own per-point tune, so plan()
+   works on LO2/LO3 settings (IF1 and the LO2/LO3 sides). From the first
+   point not yet covered it takes the setting that stays usable longest,
+   with LO1 on either side. That greedy choice gives the fewest LO2/LO3
+   changes. Ties go, in order, to:
+
+     1. fewer LO2/LO3 retunes at the change (keeping LO3, say)
+     2. fewer LO1 output-divider changes
+     3. IF1 nearest the centre of the passband
+
+   Inside a setting LO1 keeps its side until that side is unusable, and
+   each LO1 run is a segment of its own, with no retune flags set.
+
+   run() carries a schedule out over any three I_PLLSynthesizer: LO2 and LO3
+   are set only at the segment starts that change them, LO1 once per point.
+
+     IfPlanner::Config cfg = {1000.0, 1200.0, 25.0, 240.0, 10.7, 23.5, 6000.0, 30.0};
+     IfPlanner planner(cfg);
+     IfPlanner::Segment seg[8];
+     uint8_t n = planner.plan(50.0, 5900.0, 0.5, seg, 8);
+     planner.run(seg, n, 50.0, 0.5, lo1, lo2, lo3, measure, &ctx);
+
+   (c) 2025 Mark Stanley, GPL-3.0-or-later
+ */
+
+#ifndef IF_PLANNER_H
+#define IF_PLANNER_H
+
+#include <stdint.h>
+#include "I_PLLSynthesizer.h"
+
+class IfPlanner {
+public:
+    enum Side : uint8_t { LOW_SIDE = 0, HIGH_SIDE = 1 };
+
+    struct Config {
+        double if1MinMHz;               // first IF filter passband
+        double if1MaxMHz;
+        double if1StepMHz;              // IF1 candidates: min, min + step, ... max
+        double if2MHz;
+        double if3MHz;
+        double loMinMHz;                // synthesizer range
+        double loMaxMHz;
+        double guardMHz;                // RF and LO1 stay this far from IF1
+    };
+
+    struct Segment {
+        uint32_t firstPoint;            // index into the sweep
+        uint32_t points;
+        double if1MHz;
+        uint8_t lo1Side;                // Side
+        uint8_t lo2Side;
+        uint8_t lo3Side;
+        bool inverted;                  // odd number of high-side stages: spectrum reversed
+        double lo2MHz;
+        double lo3MHz;
+        bool retuneLO2;                 // set at this segment's start
+        bool retuneLO3;
+    };
+
+    // Called after LO1 is set for each point
+    typedef void (*PointFn)(uint32_t index, double rfMHz, void* ctx);
+
+    explicit IfPlanner(const Config& config) : _cfg(config) {}
+
+    // Segments for start, start + step, ... stop. Returns the count, or 0 when
+    // some point has no usable plan or 'maxSegments' is too small.
+    uint8_t plan(double startMHz, double stopMHz, double stepMHz,
+                 Segment* out, uint8_t maxSegments) const;
+
+    static uint32_t pointCount(double startMHz, double stopMHz, double stepMHz);
+    static double lo1For(const Segment& seg, double rfMHz);
+    static uint32_t retunes(const Segment* seg, uint8_t count);     // LO2 + LO3 settings
+
+    // Returns the number of points played
+    uint32_t run(const Segment* seg, uint8_t count, double startMHz, double stepMHz,
+                 I_PLLSynthesizer& lo1, I_PLLSynthesizer& lo2, I_PLLSynthesizer& lo3,
+                 PointFn point = nullptr, void* ctx = nullptr) const;
+
+private:
+    struct Option {
+        double if1MHz;
+        uint8_t lo1Side;
+        uint8_t lo2Side;
+        uint8_t lo3Side;
+    };
+
+    Config _cfg;
+
+    uint16_t optionCount() const;
+    void option(uint16_t index, Option& opt) const;
+    bool usable(const Option& opt, double rfMHz) const;
+    uint32_t walk(const Option& group, double startMHz, double stepMHz, uint32_t i, uint32_t n,
+                  uint16_t& divChanges, Segment* out, uint8_t& count, uint8_t maxSegments) const;
+    bool inRange(double loMHz) const { return loMHz >= _cfg.loMinMHz && loMHz <= _cfg.loMaxMHz; }
+    static double lo2For(const Option& opt, double if2MHz);
+    static double lo3For(const Option& opt, double if2MHz, double if3MHz);
+    static uint8_t outputDivider(double loMHz);
+};
+
+#endif // IF_PLANNER_H
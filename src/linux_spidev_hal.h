@@ -0,0 +1,207 @@
+/* linux_spidev_hal.h
+   (MAX2871 transport for Linux single-board computers)
+
+   Talks to the MAX2871 through /dev/spidevX.Y with LE wired to the SPI
+   chip select. CS is active-low, so its rising edge at the end of each
+   32-bit word is exactly the LE latch edge. All words of one update are
+   submitted as a single SPI_IOC_MESSAGE with cs_change set between them,
+   i.e. one system call per update instead of one per register.
+
+   CE and MUXOUT are optional lines on a GPIO character device
+   (/dev/gpiochipN, v2 uAPI). Delays use the monotonic clock, so they are
+   immune to wall-clock steps.
+
+     LinuxSpidevHAL hal;
+     hal.begin("/dev/spidev0.0", 20000000, "/dev/gpiochip0", 25, 24);   // CE = 25, MUXOUT = 24
+     MAX2871 lo(66.0, hal, hal);
+
+   Every system call goes through a LinuxSysOps table, so tests can swap in
+   fakes. attach() takes over descriptors that were opened elsewhere; the
+   HAL closes them in end() or its destructor, like the ones begin() opens.
+
+   (c) 2025 Mark Stanley, GPL-3.0-or-later
+ */
+
+#ifndef LINUX_SPIDEV_HAL_H
+#define LINUX_SPIDEV_HAL_H
+
+#if defined(__linux__) && !defined(ARDUINO)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/gpio.h>
+#include <linux/spi/spidev.h>
+
+#include "mcu_hal.h"
+#include "max2871_transport.h"
+
+struct LinuxSysOps {
+    int (*open)(const char* path, int flags);
+    int (*close)(int fd);
+    int (*ioctl)(int fd, unsigned long request, void* arg);
+
+    static int sysOpen(const char* path, int flags) { return ::open(path, flags); }
+    static int sysClose(int fd) { return ::close(fd); }
+    static int sysIoctl(int fd, unsigned long request, void* arg) { return ::ioctl(fd, request, arg); }
+
+    static const LinuxSysOps& system() {
+        static const LinuxSysOps ops = {sysOpen, sysClose, sysIoctl};
+        return ops;
+    }
+};
+
+class LinuxSpidevHAL : public IDelayProvider, public I_MAX2871Transport {
+public:
+    static constexpr uint8_t NO_LINE = 0xFF;
+    static constexpr uint8_t MAX_BATCH = 7;     // one message per update, worst case 6 words
+
+    explicit LinuxSpidevHAL(const LinuxSysOps& ops = LinuxSysOps::system())
+        : _ops(ops), _spiFd(-1), _ceFd(-1), _muxFd(-1), _spiHz(20000000UL), _errors(0) {}
+
+    ~LinuxSpidevHAL() { end(); }
+
+    // Open and configure the spidev node (mode 0, 8-bit words, MSB first) and
+    // request the optional CE/MUXOUT lines. Returns false if anything failed.
+    bool begin(const char* spidev, uint32_t spiHz = 20000000UL, const char* gpiochip = nullptr,
+               uint8_t ceLine = NO_LINE, uint8_t muxLine = NO_LINE) {
+        end();
+        _spiHz = spiHz;
+        _spiFd = _ops.open(spidev, O_RDWR | O_CLOEXEC);
+        if (_spiFd < 0) return false;
+
+        uint8_t mode = SPI_MODE_0;
+        uint8_t bits = 8;
+        uint8_t lsbFirst = 0;
+        if (_ops.ioctl(_spiFd, SPI_IOC_WR_MODE, &mode) < 0 ||
+            _ops.ioctl(_spiFd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0 ||
+            _ops.ioctl(_spiFd, SPI_IOC_WR_LSB_FIRST, &lsbFirst) < 0 ||
+            _ops.ioctl(_spiFd, SPI_IOC_WR_MAX_SPEED_HZ, &_spiHz) < 0) {
+            end();
+            return false;
+        }
+
+        if (gpiochip && (ceLine != NO_LINE || muxLine != NO_LINE)) {
+            int chip = _ops.open(gpiochip, O_RDWR | O_CLOEXEC);
+            if (chip < 0) {
+                end();
+                return false;
+            }
+            if (ceLine != NO_LINE) _ceFd = requestLine(chip, ceLine, GPIO_V2_LINE_FLAG_OUTPUT);
+            if (muxLine != NO_LINE) _muxFd = requestLine(chip, muxLine, GPIO_V2_LINE_FLAG_INPUT);
+            _ops.close(chip);                   // line fds stay valid without the chip fd
+            if ((ceLine != NO_LINE && _ceFd < 0) || (muxLine != NO_LINE && _muxFd < 0)) {
+                end();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Take ownership of descriptors opened elsewhere: a configured spidev fd
+    // and line-request fds. Closes any the HAL already holds first.
+    void attach(int spiFd, int ceFd = -1, int muxFd = -1, uint32_t spiHz = 20000000UL) {
+        end();
+        _spiFd = spiFd;
+        _ceFd = ceFd;
+        _muxFd = muxFd;
+        _spiHz = spiHz;
+    }
+
+    void end() {
+        if (_spiFd >= 0) _ops.close(_spiFd);
+        if (_ceFd >= 0) _ops.close(_ceFd);
+        if (_muxFd >= 0) _ops.close(_muxFd);
+        _spiFd = _ceFd = _muxFd = -1;
+    }
+
+    // Timing
+    void delayMs(uint32_t ms) override {
+        struct timespec until;
+        clock_gettime(CLOCK_MONOTONIC, &until);
+        until.tv_sec += ms / 1000;
+        until.tv_nsec += (long)(ms % 1000) * 1000000L;
+        if (until.tv_nsec >= 1000000000L) {
+            until.tv_sec++;
+            until.tv_nsec -= 1000000000L;
+        }
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, nullptr) == EINTR) {}
+    }
+
+    // MAX2871 helpers
+    void spiWriteRegister(uint32_t value) override {
+        spiWriteRegisters(&value, 1);
+    }
+
+    void spiWriteRegisters(const uint32_t* values, uint8_t count) override {
+        while (count) {
+            uint8_t n = count < MAX_BATCH ? count : MAX_BATCH;
+            struct spi_ioc_transfer xfer[MAX_BATCH];
+            uint8_t tx[MAX_BATCH][4];
+            memset(xfer, 0, sizeof(xfer));
+            for (uint8_t i = 0; i < n; ++i) {
+                tx[i][0] = (uint8_t)(values[i] >> 24);      // MSB first
+                tx[i][1] = (uint8_t)(values[i] >> 16);
+                tx[i][2] = (uint8_t)(values[i] >> 8);
+                tx[i][3] = (uint8_t)values[i];
+                xfer[i].tx_buf = (uint64_t)(uintptr_t)tx[i];
+                xfer[i].len = 4;
+                xfer[i].speed_hz = _spiHz;
+                xfer[i].bits_per_word = 8;
+                xfer[i].cs_change = (i + 1 < n) ? 1 : 0;     // CS (LE) rises after every word
+            }
+            if (_ops.ioctl(_spiFd, SPI_IOC_MESSAGE(n), xfer) < 0) _errors++;
+            values += n;
+            count -= n;
+        }
+    }
+
+    void setCEPin(bool enable) {
+        if (_ceFd < 0) return;
+        struct gpio_v2_line_values v;
+        v.mask = 1;
+        v.bits = enable ? 1 : 0;
+        if (_ops.ioctl(_ceFd, GPIO_V2_LINE_SET_VALUES_IOCTL, &v) < 0) _errors++;
+    }
+
+    bool readMuxout() override {
+        if (_muxFd < 0) return false;
+        struct gpio_v2_line_values v;
+        v.mask = 1;
+        v.bits = 0;
+        if (_ops.ioctl(_muxFd, GPIO_V2_LINE_GET_VALUES_IOCTL, &v) < 0) {
+            _errors++;
+            return false;
+        }
+        return (v.bits & 1) != 0;
+    }
+
+    uint32_t errors() const { return _errors; }     // failed transfers and line accesses
+
+private:
+    const LinuxSysOps& _ops;
+    int _spiFd;
+    int _ceFd;
+    int _muxFd;
+    uint32_t _spiHz;
+    uint32_t _errors;
+
+    int requestLine(int chip, uint8_t line, uint64_t flags) {
+        struct gpio_v2_line_request req;
+        memset(&req, 0, sizeof(req));
+        req.offsets[0] = line;
+        req.num_lines = 1;
+        req.config.flags = flags;
+        strncpy(req.consumer, "max2871", sizeof(req.consumer) - 1);
+        if (_ops.ioctl(chip, GPIO_V2_GET_LINE_IOCTL, &req) < 0) return -1;
+        return req.fd;
+    }
+};
+
+#endif // __linux__ && !ARDUINO
+
+#endif // LINUX_SPIDEV_HAL_H
@@ -12,7 +12,7 @@ void loop()
 {
 }
 #endif
-#else
+#elif !defined(MAX2871_BENCHMARK)      // bench_native brings its own main()
 int main()
 {
     return 0;
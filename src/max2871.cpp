@@ -1,103 +1,327 @@
 #include "max2871.h"
 #include "hal.h"
+#include "max2871_image.h"
 
 // ---- Static read-only defaults ----
-const MAX2871::max2871Registers MAX2871::defaultRegisters = {{
-    /* 50.0 MHz target with 60.0 MHz refClock
-     * Use for max2871 evaluation board
-     */
-    // 0x001D1740, // R0
-    // 0x4000FFE1, // R1
-    // 0x80005F42, // R2
-    // 0x00009F23, // R3
-    // 0x63EE83FC, // R4    RF_A and RF_B on @ +5 dBm // DIVA = div-by-64
-    // 0x00400005, // R5
-
-    /* 60.0 MHz target with 66.0 Mhz refClock
-     * User for Spectrum Analyzer RF board
-     */
-    0x001D1740,  // Register 0 - Contains F and parts of N
-    0x40017FE1,  // Register 1 - Contains M
-    0x80005F42,  // Register 2 - Digital Lock Detect (DLD) on
-    0x00001F23,  // Register 3
-    0x63EE81FC,  // Register 4  RF_A off // RF_B @ +5 dBm // DIVA = div-by-64
-    0x00400005   // Register 5
-}};
+
+/* 60.0 MHz target with 66.0 MHz refClock
+ * Used for Spectrum Analyzer RF board
+ * RF_A and RF_B on @ +5 dBm // DIVA = div-by-64
+ */
+static constexpr MAX2871::max2871Registers spectrumAnalyzerDefaults =
+    max2871image::build(66.0, 60.0, RF_ALL, +5);
+
+// The image used to be hand-typed; keep the derived one pinned to those words
+static_assert(spectrumAnalyzerDefaults.Reg[0] == 0x001D1740, "R0: F and N for 60 MHz");
+static_assert(spectrumAnalyzerDefaults.Reg[1] == 0x40017FE1, "R1: M for 60 MHz");
+static_assert(spectrumAnalyzerDefaults.Reg[2] == 0x80005F42, "R2: Digital Lock Detect (DLD) on");
+static_assert(spectrumAnalyzerDefaults.Reg[3] == 0x00001F23, "R3");
+static_assert(spectrumAnalyzerDefaults.Reg[4] == 0x63EE81FC, "R4: outputs on @ +5 dBm, div-by-64");
+static_assert(spectrumAnalyzerDefaults.Reg[5] == 0x00400005, "R5");
+
+/* 50.0 MHz target with 60.0 MHz refClock
+ * Use for max2871 evaluation board
+ */
+// 0x001D1740, // R0
+// 0x4000FFE1, // R1
+// 0x80005F42, // R2
+// 0x00009F23, // R3
+// 0x63EE83FC, // R4    RF_A and RF_B on @ +5 dBm // DIVA = div-by-64
+// 0x00400005, // R5
+
+const MAX2871::max2871Registers MAX2871::defaultRegisters = spectrumAnalyzerDefaults;
 
 // ---- Construction ----
 
 /* hal defaults to nullptr */
-// First use of _dirtyMask marks all 6 registers as requiring updates
+// First use of _dirtyMask forces all 6 registers to be programmed
 MAX2871::MAX2871(double refMHz, I_MAX2871Transport& transport, IDelayProvider& timing)
-    : _refMHz(refMHz),
+    : Curr(defaultRegisters),
+      Frac(0), M(0), N(0), DIVA(0),
+      Fpfd(refMHz), R(1),
+      _refMHz(refMHz),
       _transport(transport),
       _timing(timing),
       _startupRegisters(defaultRegisters),
       first_init(true),
-      _dirtyMask(0x3F) {
+      _dirtyMask(0x3F),
+      _written(defaultRegisters),
+      _octaveVcoMHz(0), _octaveR0(0), _octaveR1(0),
+      _octaveToleranceHz(0) {
 }
 
 MAX2871::MAX2871(double refMHz, I_MAX2871Transport& transport, IDelayProvider& timing,
                  const max2871Registers& startupRegisters)
-    : _refMHz(refMHz),
+    : Curr(startupRegisters),
+      Frac(0), M(0), N(0), DIVA(0),
+      Fpfd(refMHz), R(1),
+      _refMHz(refMHz),
       _transport(transport),
       _timing(timing),
       _startupRegisters(startupRegisters),
       first_init(true),
-      _dirtyMask(0x3F) {
+      _dirtyMask(0x3F),
+      _written(startupRegisters),
+      _octaveVcoMHz(0), _octaveR0(0), _octaveR1(0),
+      _octaveToleranceHz(0) {
 }
 
 void MAX2871::begin() {
     reset();  // Fill the working (shadow) registers
 }
 
+/*  Warm start after an MCU-only reset (watchdog, brown-out on the MCU rail).
+    'image' is the Curr the application persisted while it was running. If
+    every word carries its own address, the chip has not been power cycled
+    (R6 POR, when the board can read it back) and the PLL reports lock, the
+    shadow is adopted as-is and no register is written. Anything else falls
+    back to the normal clean-clock begin(). Returns true on a warm start.
+ */
+bool MAX2871::beginWarm(const max2871Registers& image) {
+    if (adoptImage(image) && !chipWasReset() && isLocked()) return true;
+    reset();
+    return false;
+}
+
+/*  Take 'image' as both the shadow and what the chip holds, without writing.
+    For words that reached the chip some other way: a warm start, or a
+    register stream decoded straight into the transport.
+ */
+bool MAX2871::adoptImage(const max2871Registers& image) {
+    for (uint8_t regAddr = 0; regAddr < 6; ++regAddr) {
+        if ((image.Reg[regAddr] & 0x7) != regAddr) return false;
+    }
+    Curr = image;
+    _written = image;
+    first_init = false;
+    _dirtyMask = 0;
+    decodeDividers();
+    return true;
+}
+
 // ---- Frequency Control ----
 
 void MAX2871::setFrequency(double freqMHz) {
-    freq2FMN(freqMHz);
-    setRegisterField(1, 14,  3, M);
-    setRegisterField(0, 14,  3, Frac);
-    setRegisterField(0, 30, 15, N);
-    setRegisterField(4, 22, 20, DIVA);
+    shadowFrequency(freqMHz);
     updateRegisters();
 }
 
 void MAX2871::setFrequency(uint32_t fmn, uint8_t diva) {
+    shadowFrequency(fmn, diva);
+    updateRegisters();
+}
+
+// Shadow half of setFrequency(): Curr and the divider members, nothing written
+void MAX2871::shadowFrequency(double freqMHz) {
+    uint8_t diva;
+    if (octaveDivider(freqMHz, diva)) {
+        setRegisterField(4, 22, 20, diva);          // as setOutputDivider()
+        decodeDividers();
+        return;
+    }
+    freq2FMN(freqMHz);
+    dividersToImage(Frac, M, N, DIVA, _startupRegisters, Curr);
+    _octaveVcoMHz = freqMHz * (1 << DIVA);
+    _octaveR0 = Curr.Reg[0];
+    _octaveR1 = Curr.Reg[1] & bitMask(14, 3);
+}
+
+void MAX2871::shadowFrequency(uint32_t fmn, uint8_t diva) {
     Frac = (fmn >> 20) & 0xFFF;
     M = (fmn >> 8) & 0xFFF;
     N = fmn & 0xFF;
     DIVA = diva;
-    setRegisterField(1, 14,  3, M);
-    setRegisterField(0, 14,  3, Frac);
-    setRegisterField(0, 30, 15, N);
-    setRegisterField(4, 22, 20, DIVA);
+    dividersToImage(Frac, M, N, DIVA, _startupRegisters, Curr);
+}
+
+/*  Octave jump: the VCO keeps its frequency and band, only DIVA moves. With
+    REG4DB clear that is one R4 word; no R0, so no VCO autocal and no relock
+    wait. With REG4DB set the new DIVA waits in the buffer and R0 follows.
+ */
+void MAX2871::setOutputDivider(uint8_t diva) {
+    if (diva > 7) return;
+    setRegisterField(4, 22, 20, diva);
     updateRegisters();
+    decodeDividers();
+}
+
+/*  setFrequency() targets of exactly 2^k times the last solved one reuse its
+    N/F/M, which is what the solver would pick again. A non-zero tolerance
+    also takes near-octaves, as long as the output the chip actually produces
+    (from N/F/M and the R2 reference path) lands within it. Only with FB = 1:
+    in divided feedback N counts the divided output, so DIVA moves the VCO.
+ */
+void MAX2871::setOctaveTolerance(float toleranceHz) {
+    _octaveToleranceHz = toleranceHz;
+}
+
+bool MAX2871::octaveDivider(double freqMHz, uint8_t& diva) const {
+    if (first_init || _octaveVcoMHz <= 0) return false;
+    if (Curr.Reg[0] != _octaveR0 || (Curr.Reg[1] & bitMask(14, 3)) != _octaveR1) return false;   // retuned since
+    if (!((Curr.Reg[4] >> 23) & 1)) return false;                   // FB = 0
+    double vcoMHz = imageVcoMHz();
+    for (uint8_t k = 0; k < 8; ++k) {
+        if (_octaveVcoMHz / (1 << k) == freqMHz ||
+            fabs(vcoMHz / (1 << k) - freqMHz) * 1e6 <= _octaveToleranceHz) {
+            diva = k;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*  Writes the dividers into 'regs' and matches the mode fields to them.
+    An exact integer-N solution (Frac = 0) runs in integer mode: INT = 1,
+    charge-pump linearity off (CPL = 0) and integer-N lock detect with the
+    6 ns window (LDF = 1, LDP = 1). Fractional solutions get this instance's
+    'start' values back. Switching modes costs the R1 and R2 words once.
+ */
+void MAX2871::dividersToImage(uint16_t frac, uint16_t m, uint16_t n, uint8_t diva,
+                              const max2871Registers& start, max2871Registers& regs) {
+    bool integerN = (frac == 0);
+    putField(regs.Reg[0], 31, 31, integerN ? 1u : 0u);
+    putField(regs.Reg[0], 30, 15, n);
+    putField(regs.Reg[0], 14,  3, frac);
+    putField(regs.Reg[1], 30, 29, integerN ? 0u : (start.Reg[1] >> 29) & 0x3);
+    putField(regs.Reg[1], 14,  3, m);
+    putField(regs.Reg[2],  8,  8, integerN ? 1u : (start.Reg[2] >> 8) & 0x1);
+    putField(regs.Reg[2],  7,  7, integerN ? 1u : (start.Reg[2] >> 7) & 0x1);
+    putField(regs.Reg[4], 22, 20, diva);
+}
+
+// Registers setFrequency(fmn, diva) would write from the current state (bit mask)
+uint8_t MAX2871::writeMask(uint32_t fmn, uint8_t diva) const {
+    fmnSolution sol;
+    sol.Frac = (fmn >> 20) & 0xFFF;
+    sol.M = (fmn >> 8) & 0xFFF;
+    sol.N = fmn & 0xFF;
+    sol.DIVA = diva;
+    return writesFor(sol);
+}
+
+uint8_t MAX2871::writesFor(const fmnSolution& sol) const {
+    max2871Registers next = Curr;
+    dividersToImage(sol.Frac, sol.M, sol.N, sol.DIVA, _startupRegisters, next);
+    return pendingWrites(next);
+}
+
+/*  Write-cost-aware solver. solveFMN() only minimises error; this looks at
+    what the chip holds now and, among the solutions within 'toleranceHz',
+    takes the one needing the fewest register words, then the smaller error.
+    Candidates are the minimum-error solution, the current M (R1 untouched)
+    and integer-N, each with the current DIVA when the VCO range allows it.
+    Returns false if none is within tolerance; 'out' is then the
+    minimum-error solution.
+ */
+bool MAX2871::solveNear(double freqMHz, float toleranceHz, costedSolution& out) const {
+    const double fpfd = _refMHz;                            // R = 1, as freq2FMN()
+    uint16_t currM = (Curr.Reg[1] >> 3) & 0xFFF;
+    uint8_t currDIVA = (Curr.Reg[4] >> 20) & 0x7;
+
+    fmnSolution cand[5];
+    uint8_t count = 0;
+    solveFMN(fpfd, freqMHz, cand[count++]);
+
+    uint8_t divas[2] = {cand[0].DIVA, cand[0].DIVA};
+    double currVco = freqMHz * (1 << currDIVA);
+    if (currDIVA != cand[0].DIVA && currVco >= 3000.0 && currVco <= 6000.0) divas[1] = currDIVA;
+    for (uint8_t d = 0; d < 2 && !(d == 1 && divas[1] == divas[0]); ++d) {
+        double nDotF = freqMHz * (1 << divas[d]) / fpfd;
+        uint16_t n = (uint16_t)nDotF;
+        if (currM > 1) {                                    // keep M: only N/F move
+            fmnSolution& s = cand[count++];
+            s.N = n;
+            s.Frac = (uint16_t)((nDotF - n) * currM + 0.5);
+            s.M = currM;
+            s.DIVA = divas[d];
+            if (s.Frac >= currM) {
+                s.Frac = 0;
+                s.N++;
+            }
+        }
+        fmnSolution& s = cand[count++];                     // integer-N
+        s.N = (uint16_t)(nDotF + 0.5);
+        s.Frac = 0;
+        s.M = currM > 1 ? currM : cand[0].M;
+        s.DIVA = divas[d];
+    }
+
+    bool found = false;
+    for (uint8_t i = 0; i < count; ++i) {
+        const fmnSolution& s = cand[i];
+        double f = fpfd * (s.N + (double)s.Frac / s.M) / (1 << s.DIVA);
+        float err = (float)(fabs(f - freqMHz) * 1e6);
+        uint8_t writes = writesFor(s);
+        uint8_t cost = 0;
+        for (uint8_t b = writes; b; b &= (uint8_t)(b - 1)) cost++;
+        bool ok = err <= toleranceHz;
+        bool better;
+        if (i == 0) better = true;
+        else if (ok != found) better = ok;
+        else if (ok) better = cost < out.cost || (cost == out.cost && err < out.errorHz);
+        else better = err < out.errorHz;
+        if (better) {
+            out.sol = s;
+            out.errorHz = err;
+            out.writes = writes;
+            out.cost = cost;
+            found = found || ok;
+        }
+    }
+    return found;
+}
+
+bool MAX2871::setFrequencyNear(double freqMHz, float toleranceHz, costedSolution* chosen) {
+    costedSolution c;
+    bool ok = solveNear(freqMHz, toleranceHz, c);
+    R = 1;
+    Fpfd = _refMHz;
+    Frac = c.sol.Frac;
+    M = c.sol.M;
+    N = c.sol.N;
+    DIVA = c.sol.DIVA;
+    dividersToImage(Frac, M, N, DIVA, _startupRegisters, Curr);
+    updateRegisters();
+    if (chosen) *chosen = c;
+    return ok;
 }
 
 void MAX2871::freq2FMN(float target_freq_MHz) {
-    float floatFrac;
     R = 1;
     Fpfd = _refMHz / R;                // Phase Frequency Detector input frequency
+    fmnSolution sol;
+    solveFMN(Fpfd, target_freq_MHz, sol);
+    Frac = sol.Frac;
+    M = sol.M;
+    N = sol.N;
+    DIVA = sol.DIVA;
+}
+
+/*  Brute-force reference solver. It touches no member state so it can be
+    shared by host tools and run from several threads at once.
+ */
+void MAX2871::solveFMN(double Fpfd, float target_freq_MHz, fmnSolution& sol) {
+    float floatFrac;
     float max_error = pow(2, 32);      // Large initial error
     float Fvco = target_freq_MHz;
 
     // Adjust Fvco to be within 3000 to 6000 MHz range and calculate DIVA accordingly
-    DIVA = 0;                           // Re-initialize DIVA (divide by 1)
+    sol.DIVA = 0;                       // Re-initialize DIVA (divide by 1)
     while (Fvco < 3000.0) {
         Fvco *= 2;                      // Double until VCO is in valid range
-        DIVA += 1;                      // Track doublings to determine DIVA
+        sol.DIVA += 1;                  // Track doublings to determine DIVA
     }
 
     float NdotF = Fvco / Fpfd;
-    N = static_cast<uint8_t>(NdotF);    // Integer portion (N of NdotF)
-    floatFrac = NdotF - N;              // Fractional portion
+    sol.N = static_cast<uint8_t>(NdotF);    // Integer portion (N of NdotF)
+    floatFrac = NdotF - sol.N;              // Fractional portion
     uint16_t best_F = 0;
     uint16_t best_M = 0;
 
     // Loop through M from 4095 down to 2
     for (uint16_t M_candidate = 4095; M_candidate > 1; --M_candidate) {
         float F_candidate = static_cast<uint16_t>(floatFrac * float(M_candidate));
-        float FvcoCalculated = Fpfd * (N + F_candidate / M_candidate);
+        float FvcoCalculated = Fpfd * (sol.N + F_candidate / M_candidate);
         float err = fabs(Fvco - FvcoCalculated);
         if (err == 0) {
             best_F = F_candidate;       // Perfect match found
@@ -111,8 +335,18 @@ void MAX2871::freq2FMN(float target_freq_MHz) {
         }
     }
 
-    Frac = static_cast<uint16_t>(round(best_F));
-    M = best_M;
+    sol.Frac = static_cast<uint16_t>(round(best_F));
+    sol.M = best_M;
+}
+
+/*  Frac < M with M in 2..4095, DIVA in 0..7, and N at least 19 (16 in
+    integer-N mode) but within the 8 bits the packed F/M/N words carry.
+    A solve whose VCO / Fpfd reaches 256 wraps N and pushes the rest into
+    Frac, which this rejects.
+ */
+bool MAX2871::validSolution(const fmnSolution& sol) {
+    if (sol.M < 2 || sol.M > 4095 || sol.Frac >= sol.M || sol.DIVA > 7) return false;
+    return sol.N >= (sol.Frac ? 19 : 16) && sol.N <= 255;
 }
 
 double MAX2871::fmn2freq() {
@@ -121,6 +355,22 @@ double MAX2871::fmn2freq() {
     return fout;
 }
 
+/*  The reference is switched on the board (REF_EN1/REF_EN2); this only moves
+    the driver onto the new Fpfd. Nothing is written here, but the next update
+    always includes R0 because the VCO must be re-selected for the new Fpfd.
+ */
+void MAX2871::setReference(double refMHz) {
+    if (refMHz == _refMHz) return;
+    _refMHz = refMHz;
+    _octaveVcoMHz = 0;                              // same words, different VCO
+    Fpfd = _refMHz / R;
+    _dirtyMask |= 1;
+}
+
+double MAX2871::reference() const {
+    return _refMHz;
+}
+
 // ---- Output Control ----
 
 // RFOutPort = RFNONE, RF_A, RF_B or RF_ALL
@@ -171,6 +421,41 @@ void MAX2871::outputPower(int dBm, RFOutPort port) {
     updateRegisters();
 }
 
+// ---- Hop / Power Control ----
+
+/*  Hop mode. With MTLD set the chip holds RFOUTA/B off from the R0 write until
+    lock detect asserts, so every setFrequency() is glitch-free without the
+    outputSelect(RFNONE)/outputSelect(...) pair around it. MUTEDEL delays the
+    lock detect seen by MTLD so the outputs also stay off through the VCO band
+    switch. Costs one R4+R3 pass when toggled, nothing per hop.
+ */
+void MAX2871::setMuteUntilLock(bool enable) {
+    setRegisterField(3, 17, 17, enable ? 1u : 0u);  // R3[17] MUTEDEL
+    setRegisterField(4, 10, 10, enable ? 1u : 0u);  // R4[10] MTLD
+    updateRegisters();
+}
+
+// Low-power shutdown: one R2 write, everything but the SPI port powers down
+void MAX2871::standby() {
+    setRegisterField(2, 5, 5, 1u);                  // R2[5] SHDN
+    updateRegisters();
+}
+
+/*  Leaving shutdown takes R2 and then R0, which restarts VCO autoselection.
+    The shadow registers were never touched, so the part comes back on the
+    frequency and output settings it had before standby().
+ */
+void MAX2871::wake() {
+    if (!isStandby()) return;
+    setRegisterField(2, 5, 5, 0u);
+    _dirtyMask |= 1;                                // R0 write starts VCO autocal
+    updateRegisters();
+}
+
+bool MAX2871::isStandby() const {
+    return (Curr.Reg[2] >> 5) & 1;
+}
+
 // ---- Status ----
 
 bool MAX2871::isLocked() {
@@ -179,8 +464,192 @@ bool MAX2871::isLocked() {
 
 // ---- Register Access ----
 
+/*  Expert access to a whole register word. The address is taken from bits [2:0]
+    exactly as the chip would decode it. The shadow copy is updated and the
+    register is programmed along with anything that depends on it. R6 is
+    read-only, so words addressed to it are ignored.
+ */
+void MAX2871::setRegister(uint32_t value) {
+    uint8_t regAddr = value & 0x7;
+    if (regAddr > 5) return;
+    setRegisterField(regAddr, 31, 3, value >> 3);
+    updateRegisters();
+    decodeDividers();           // N/F/M, DIVA and Fpfd follow the raw word
+}
+
+/*  Words another instance already sequenced (a solver worker, a host plan):
+    written as given, in one batch, and taken into the shadow. The caller
+    owns the ordering; no write rules are applied.
+ */
+void MAX2871::writeWords(const uint32_t* words, uint8_t count) {
+    for (uint8_t i = 0; i < count; ++i) {
+        if ((words[i] & 0x7) > 5) return;
+    }
+    writeRegisters(words, count);
+    for (uint8_t i = 0; i < count; ++i) Curr.Reg[words[i] & 0x7] = words[i];
+    decodeDividers();
+}
+
+// Inverse of the unpacking done in setFrequency(uint32_t fmn, uint8_t diva)
+uint32_t MAX2871::packedFMN() const {
+    return ((uint32_t)(Frac & 0xFFF) << 20) | ((uint32_t)(M & 0xFFF) << 8) | (N & 0xFF);
+}
+
+uint32_t MAX2871::packedFMN(const fmnSolution& sol) {
+    return ((uint32_t)(sol.Frac & 0xFFF) << 20) | ((uint32_t)(sol.M & 0xFFF) << 8) | (sol.N & 0xFF);
+}
+
+/*  Read R6 and report its POR flag (R6[23]), which is set when the chip has
+    lost its registers. MUX = 1100 (R5[18] + R2[28:26]) routes the readback to
+    MUXOUT; the shadow words are written back afterwards. Boards that cannot
+    read back cost nothing and report no reset.
+ */
+bool MAX2871::chipWasReset() {
+    if (!_transport.canReadRegisters()) return false;
+    writeRegister(Curr.Reg[5] | fieldValue(1, 18, 18));
+    writeRegister((Curr.Reg[2] & ~bitMask(28, 26)) | fieldValue(4, 28, 26));
+    uint32_t r6 = _transport.readRegister6();
+    writeRegister(Curr.Reg[2]);
+    writeRegister(Curr.Reg[5]);
+    return (r6 & 0x7) != 6 || ((r6 >> 23) & 1);
+}
+
+// Recover the divider members from the shadow registers
+void MAX2871::decodeDividers() {
+    N = (Curr.Reg[0] >> 15) & 0xFFFF;
+    Frac = (Curr.Reg[0] >> 3) & 0xFFF;
+    M = (Curr.Reg[1] >> 3) & 0xFFF;
+    DIVA = (Curr.Reg[4] >> 20) & 0x7;
+    R = (Curr.Reg[2] >> 14) & 0x3FF;
+    if (R == 0) R = 1;
+    Fpfd = _refMHz * (1 + ((Curr.Reg[2] >> 25) & 1))        // DBR doubles
+                   / (R * (1 + ((Curr.Reg[2] >> 24) & 1)));  // RDIV2 halves
+}
+
+// VCO frequency the shadow's N/F/M and R2 reference path give
+double MAX2871::imageVcoMHz() const {
+    uint16_t r = (Curr.Reg[2] >> 14) & 0x3FF;
+    uint16_t m = (Curr.Reg[1] >> 3) & 0xFFF;
+    double fpfd = _refMHz * (1 + ((Curr.Reg[2] >> 25) & 1)) / ((r ? r : 1) * (1 + ((Curr.Reg[2] >> 24) & 1)));
+    return fpfd * (((Curr.Reg[0] >> 15) & 0xFFFF) + (double)((Curr.Reg[0] >> 3) & 0xFFF) / (m ? m : 1));
+}
+
 void MAX2871::writeRegister(uint32_t value) {
     _transport.spiWriteRegister(value);
+    _written.Reg[value & 0x7] = value;
+}
+
+// One batch per update so the transport can submit it as a single transfer
+void MAX2871::writeRegisters(const uint32_t* values, uint8_t count) {
+    if (count == 0) return;
+    _transport.spiWriteRegisters(values, count);
+    for (uint8_t i = 0; i < count; ++i) _written.Reg[values[i] & 0x7] = values[i];
+}
+
+// ---- Write sequencing ----
+
+/*  What the chip does with each word, as far as write ordering is concerned.
+    A change to any of 'fields' in register 'reg' also requires the registers
+    in 'writeAlso' to be programmed. 'condBit', when non-zero, names an R2 bit
+    that must be set for the rule to apply. It is read from the R2 the chip
+    already holds: R2 goes out after R3-R5, so a new R2 value in the same
+    pass comes too late to change how those words are taken.
+
+    Ordering needs no table of its own: R0 is the commit point for everything
+    below, so writing from R5 down to R0 always puts it last.
+ */
+struct WriteRule {
+    uint8_t reg;
+    uint32_t fields;
+    uint8_t condBit;
+    uint8_t writeAlso;
+};
+
+static const uint32_t R1_BUFFERED = 0x07FFFFF8;    // P[26:15], M[14:3]
+static const uint32_t R4_BUFFERED = 0x037FF000;    // BS[25:24,19:12], DIVA[22:20]
+
+static const WriteRule writeRules[] = {
+    // R1 M and P are double-buffered until the next R0 write
+    {1, R1_BUFFERED, 0, 1 << 0},
+    // R4 BS and DIVA are double-buffered when R2 REG4DB is set
+    {4, R4_BUFFERED, 13, 1 << 0},
+    // R2 DBR, RDIV2 and R[23:14] change Fpfd, so the VCO must be re-selected
+    {2, 0x03FFC000, 0, 1 << 0},
+    // R3 VCO[31:26] and VAS_SHDN take effect through the R0-triggered autocal
+    {3, 0xFE000000, 0, 1 << 0},
+};
+
+// Registers that must be written to move a chip holding 'written' to 'target'
+uint8_t MAX2871::requiredWrites(const max2871Registers& target, const max2871Registers& written) {
+    uint8_t writes = 0;
+    for (uint8_t regAddr = 0; regAddr < 6; ++regAddr) {
+        if (target.Reg[regAddr] != written.Reg[regAddr]) writes |= (1 << regAddr);
+    }
+    for (uint8_t i = 0; i < sizeof(writeRules) / sizeof(writeRules[0]); ++i) {
+        const WriteRule& rule = writeRules[i];
+        uint32_t changed = (target.Reg[rule.reg] ^ written.Reg[rule.reg]) & rule.fields;
+        bool applies = rule.condBit == 0 || ((written.Reg[2] >> rule.condBit) & 1);
+        if (changed && applies) writes |= rule.writeAlso;
+    }
+    return writes;
+}
+
+uint8_t MAX2871::pendingWrites(const max2871Registers& target) const {
+    return _dirtyMask | requiredWrites(target, _written);
+}
+
+/*  Pre-staged tuning. The double-buffered fields (R1 M/P, and R4 DIVA/BS
+    while the chip runs with REG4DB set) only reach the synthesizer on the
+    next R0 write, so they can be loaded during the current dwell. Everything
+    else the new point needs would take effect at once and is left for
+    latch(), together with R0. For a fractional hop that keeps the VCO band
+    and mode, latch() is the single R0 word.
+
+    Any other update between the two commits the staged point early.
+ */
+void MAX2871::stageFrequency(double freqMHz) {
+    freq2FMN(freqMHz);
+    stageDividers();
+}
+
+void MAX2871::stageFrequency(uint32_t fmn, uint8_t diva) {
+    Frac = (fmn >> 20) & 0xFFF;
+    M = (fmn >> 8) & 0xFFF;
+    N = fmn & 0xFF;
+    DIVA = diva;
+    stageDividers();
+}
+
+void MAX2871::latch() {
+    updateRegisters();
+}
+
+bool MAX2871::isStaged() const {
+    return !first_init && pendingWrites(Curr) != 0;
+}
+
+// R2[13] REG4DB: DIVA and BS wait for R0 like M and P, so they can be staged too
+void MAX2871::setDoubleBuffer(bool enable) {
+    setRegisterField(2, 13, 13, enable ? 1u : 0u);
+    updateRegisters();
+}
+
+void MAX2871::stageDividers() {
+    dividersToImage(Frac, M, N, DIVA, _startupRegisters, Curr);
+    if (first_init) {
+        updateRegisters();                              // nothing running yet to protect
+        return;
+    }
+    uint32_t words[2];
+    uint8_t count = 0;
+    uint32_t r4 = (_written.Reg[4] & ~R4_BUFFERED) | (Curr.Reg[4] & R4_BUFFERED);
+    if (((_written.Reg[2] >> 13) & 1) && r4 != _written.Reg[4]) words[count++] = r4;
+    uint32_t r1 = (_written.Reg[1] & ~R1_BUFFERED) | (Curr.Reg[1] & R1_BUFFERED);
+    if (r1 != _written.Reg[1]) words[count++] = r1;
+    if (count) {
+        writeRegisters(words, count);
+        _dirtyMask |= 1;                                // latch() must still send R0
+    }
 }
 
 /*  At power-up, the registers should be programmed twice. The first
@@ -189,23 +658,37 @@ void MAX2871::writeRegister(uint32_t value) {
 */
 void MAX2871::updateRegisters() {
     // First cycle ensures a clean-clock startup
+    uint32_t words[6];
+    uint8_t count = 0;
     if (first_init) {
         writeRegister(Curr.Reg[5]);                         // Program reg 5
         _timing.delayMs(20);
-        writeRegister(Curr.Reg[4] & 0xFFFFFEDF);            // Program reg 4, RFOUTA and B disabled
+        words[count++] = Curr.Reg[4] & 0xFFFFFEDF;          // Program reg 4, RFOUTA and B disabled
         for (int regAddr = 3; regAddr >= 0; --regAddr) {    // Program reg 3, 2, 1, 0
-            writeRegister(Curr.Reg[regAddr]);
+            words[count++] = Curr.Reg[regAddr];
         }
+        writeRegisters(words, count);
+        count = 0;
         _dirtyMask = 0x3F;                                  // 6 Registers marked for second cycle
     }
 
-    // Second/Normal cycle programs only the registers that have changed
+    // Second/Normal cycle programs only what the write rules require
+    count = takeWrites(words);
+    if (count) _transport.spiWriteRegisters(words, count);
+}
+
+// Words the write rules require, R5 first, recorded as written
+uint8_t MAX2871::takeWrites(uint32_t* words) {
+    uint8_t writes = pendingWrites(Curr);
+    uint8_t count = 0;
     for (int regAddr = 5; regAddr >= 0; --regAddr) {
-        if ((_dirtyMask & (1UL << regAddr)) != 0) {
-            writeRegister(Curr.Reg[regAddr]);
+        if ((writes & (1UL << regAddr)) != 0) {
+            words[count++] = Curr.Reg[regAddr];
+            _written.Reg[regAddr] = Curr.Reg[regAddr];
         }
     }
     _dirtyMask = 0;
+    return count;
 }
 
 // Reset working copy of registers, Curr, from the defaultRegisters
@@ -216,6 +699,11 @@ void MAX2871::reset() {
     first_init = false;         // Done running clean-clock startup
 }
 
+// Field write on a plain word, for images that are not the live shadow
+void MAX2871::putField(uint32_t& word, uint8_t bit_hi, uint8_t bit_lo, uint32_t value) {
+    word = (word & ~bitMask(bit_hi, bit_lo)) | fieldValue(value, bit_hi, bit_lo);
+}
+
 /*  This function provides the expert with the ability to manually change the bits
     within the registers. You can stack as many calls to setRegisterField as you like
     and then make a call to updateRegisters() to program the chip with your changes.
@@ -231,15 +719,8 @@ void MAX2871::setRegisterField(uint8_t regAddr, uint8_t bit_hi, uint8_t bit_lo,
     // Return early if stepping on address bits, exceeding 32 bits or the address range
     if (bit_lo < 3 || bit_hi > 31 || regAddr > 6) return;
 
-    // --- Check Register values ---
-    uint32_t oldReg = Curr.Reg[regAddr];                // Checking for Curr.Reg value changes
+    // --- Update the shadow; updateRegisters() works out what to write ---
     uint32_t mask = bitMask(bit_hi, bit_lo);            // Create mask for clearing bit field
     uint32_t data = fieldValue(value, bit_hi, bit_lo);  // Create data for filling field
-    uint32_t newReg = (Curr.Reg[regAddr] & ~mask) | data;
-    if (newReg != oldReg) {
-        Curr.Reg[regAddr] = newReg;
-        _dirtyMask |= (1 << regAddr);  // selected register being marked for update
-    }
-    _dirtyMask |= (_dirtyMask >> 1) & 1UL;  // If reg1 is marked then mark reg0 (double buffer)
-    _dirtyMask |= (_dirtyMask >> 4) & 1UL;  // If reg4 is marked then mark reg0
+    Curr.Reg[regAddr] = (Curr.Reg[regAddr] & ~mask) | data;
 }
@@ -13,6 +13,22 @@ public:
     uint32_t Reg[numRegisters];
   };
 
+  // Divider settings produced by the frequency solver
+  struct fmnSolution {
+    uint16_t Frac;
+    uint16_t M;
+    uint16_t N;
+    uint8_t DIVA;
+  };
+
+  // What solveNear() picked: dividers, output error and what tuning to them costs
+  struct costedSolution {
+    fmnSolution sol;
+    float errorHz;
+    uint8_t writes;                 // register mask, as writeMask()
+    uint8_t cost;                   // number of words
+  };
+
   // explicit MAX2871(double refIn);
   explicit MAX2871(double refMHz, I_MAX2871Transport& transport, IDelayProvider& timing);
   MAX2871(double refMHz, I_MAX2871Transport& transport, IDelayProvider& timing,
@@ -20,18 +36,60 @@ public:
   MAX2871() = delete;                                       // Disallow empty constructor
   void begin() override;
   void reset();
+  bool beginWarm(const max2871Registers& image);            // skip clean-clock if still locked
+  bool adoptImage(const max2871Registers& image);           // chip already holds 'image'
   bool isLocked() override;
 
   // ---- Frequency Control ----
   void setFrequency(double freqMHz) override;               // calculates FMN+DIVA
   void setFrequency(uint32_t fmn, uint8_t diva) override;   // bypass math
   void freq2FMN(float target_freq_MHz);                     // calculate F,M,N,DIVA
+  static void solveFMN(double Fpfd, float target_freq_MHz, fmnSolution& sol);  // stateless solver
+  static bool validSolution(const fmnSolution& sol);       // dividers the chip can take
   double fmn2freq();                                        // reverse calc
+  bool solveNear(double freqMHz, float toleranceHz, costedSolution& out) const;  // fewest writes
+  bool setFrequencyNear(double freqMHz, float toleranceHz, costedSolution* chosen = nullptr);
+  void setOutputDivider(uint8_t diva);                      // R4 DIVA only, VCO left running
+  void setOctaveTolerance(float toleranceHz);               // 2^k retunes within this skip the solver
+  void stageFrequency(double freqMHz);                      // preload R1 (and R4) buffers only
+  void stageFrequency(uint32_t fmn, uint8_t diva);
+  void latch();                                             // rest of the staged point, R0 last
+  bool isStaged() const;                                    // something is waiting for latch()
+  void setDoubleBuffer(bool enable);                        // R2[13] REG4DB, lets DIVA be staged
+  void setReference(double refMHz);                         // after switching the board's REF_EN
+  double reference() const;
+
+  // ---- Direct write path ----
+  // The same tunes with the transport passed by its concrete type. For a
+  // 'final' transport such as BoardTransport the words go out through a direct
+  // call, not through I_MAX2871Transport. It must be the transport this driver
+  // was built with; any other object (and the clean-clock startup) takes the
+  // virtual path.
+  template <class Transport> void setFrequency(double freqMHz, Transport& transport);
+  template <class Transport> void setFrequency(uint32_t fmn, uint8_t diva, Transport& transport);
 
   // ---- Output Control ----
   void outputSelect(RFOutPort port = RF_ALL) override;          // A, B, both, or off
   void outputPower(int dBm, RFOutPort port = RF_ALL) override;  // -4, -1, +2, +5 dBm
 
+  // ---- Hop / Power Control ----
+  void setMuteUntilLock(bool enable);                       // R4[10] MTLD + R3[17] MUTEDEL
+  void standby();                                           // R2[5] SHDN, shadow kept
+  void wake();                                              // leave standby, rerun VCO autocal
+  bool isStandby() const;
+
+  // ---- Register Access ----
+  void setRegister(uint32_t value);                         // raw word, address in bits [2:0]
+  void writeWords(const uint32_t* words, uint8_t count);    // words prepared elsewhere, in order
+  uint32_t packedFMN() const;                               // Frac/M/N as setFrequency(fmn, diva) expects
+  static uint32_t packedFMN(const fmnSolution& sol);        // the same for a solver result
+  uint8_t writeMask(uint32_t fmn, uint8_t diva) const;      // registers that tune would write
+
+  // ---- Register model shared with MAX2871Bank ----
+  static uint8_t requiredWrites(const max2871Registers& target, const max2871Registers& written);
+  static void dividersToImage(uint16_t frac, uint16_t m, uint16_t n, uint8_t diva,
+                              const max2871Registers& startup, max2871Registers& regs);
+
   // Default registers - Read-only
   static const max2871Registers defaultRegisters;
   // Working registers - Read/Write
@@ -51,11 +109,53 @@ private:
   IDelayProvider& _timing;
   max2871Registers _startupRegisters;
   bool first_init;
-  uint8_t _dirtyMask;               // Track which registers require programming
+  uint8_t _dirtyMask;               // Registers to program even if unchanged
+  max2871Registers _written;        // Last word sent to each register
+  double _octaveVcoMHz;             // VCO target of the last solved setFrequency(), 0 = none
+  uint32_t _octaveR0;               // and the R0 / R1 M words it produced
+  uint32_t _octaveR1;
+  float _octaveToleranceHz;
 
   void writeRegister(uint32_t value);
+  void writeRegisters(const uint32_t* values, uint8_t count);
+  bool chipWasReset();
+  void decodeDividers();
+  bool octaveDivider(double freqMHz, uint8_t& diva) const;
+  double imageVcoMHz() const;
+  void stageDividers();
+  uint8_t writesFor(const fmnSolution& sol) const;
   void updateRegisters();
+  uint8_t takeWrites(uint32_t* words);
+  template <class Transport> void updateRegisters(Transport& transport);
+  void shadowFrequency(double freqMHz);
+  void shadowFrequency(uint32_t fmn, uint8_t diva);
+  uint8_t pendingWrites(const max2871Registers& target) const;
+  static void putField(uint32_t& word, uint8_t bit_hi, uint8_t bit_lo, uint32_t value);
   void setRegisterField(uint8_t reg, uint8_t bit_hi, uint8_t bit_lo, uint32_t value);
 };
 
+template <class Transport>
+void MAX2871::setFrequency(double freqMHz, Transport& transport) {
+  shadowFrequency(freqMHz);
+  updateRegisters(transport);
+}
+
+template <class Transport>
+void MAX2871::setFrequency(uint32_t fmn, uint8_t diva, Transport& transport) {
+  shadowFrequency(fmn, diva);
+  updateRegisters(transport);
+}
+
+// updateRegisters() with the concrete transport type known at the call
+template <class Transport>
+void MAX2871::updateRegisters(Transport& transport) {
+  if (first_init || static_cast<I_MAX2871Transport*>(&transport) != &_transport) {
+    updateRegisters();
+    return;
+  }
+  uint32_t words[6];
+  uint8_t count = takeWrites(words);
+  if (count) transport.spiWriteRegisters(words, count);
+}
+
 #endif
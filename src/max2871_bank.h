@@ -0,0 +1,182 @@
+/* max2871_bank.h
+   (Several MAX2871s on one SPI bus, programmed together)
+
+   A MAX2871 object carries its own reference, Fpfd, divider copies, startup
+   image and vtable pointer. MAX2871Bank<N> keeps only what the chips need:
+   one shared reference and startup image, and the register images of all N
+   chips in register-major arrays, so the same register of every chip sits
+   side by side.
+
+   Because the chips share DATA and CLK, a word only has to be shifted once;
+   pulsing several LE lines afterwards latches it into each of them. update()
+   walks R5..R0 and, per register, writes each distinct word once with the
+   LE mask of every chip that needs it. Bring-up is fully shared: for three
+   LOs it is 12 words and one 20 ms wait instead of 36 words and three waits.
+
+     static const uint8_t le[] = {A3, A4, 3};
+     static const uint8_t mux[] = {A2, A2, A2};
+     ArduinoBankHAL bus(le, mux, 3);
+     MAX2871Bank<3> los(66.0, bus, bus);
+     los.begin();
+     los.setFrequency(0, 3000.0);           // stage per-chip changes...
+     los.setFrequency(1, 1200.0);
+     los.outputPower(2, +2);
+     los.update();                          // ...then program them together
+
+   Write ordering, double buffering and integer-N handling come from the same
+   rules as the MAX2871 class (MAX2871::requiredWrites, dividersToImage).
+
+   (c) 2025 Mark Stanley, GPL-3.0-or-later
+ */
+
+#ifndef MAX2871_BANK_H
+#define MAX2871_BANK_H
+
+#include <stdint.h>
+#include "hal.h"
+#include "mcu_hal.h"
+#include "max2871.h"
+
+// Shared-bus transport: one word, latched into every chip set in 'leMask'
+class I_MAX2871BankTransport {
+public:
+    virtual ~I_MAX2871BankTransport() {}
+
+    virtual void spiWriteRegister(uint32_t value, uint8_t leMask) = 0;
+    virtual bool readMuxout(uint8_t chip) = 0;
+};
+
+template <uint8_t N>
+class MAX2871Bank {
+    static_assert(N >= 1 && N <= 8, "MAX2871Bank: 1..8 chips (one LE bit each)");
+
+public:
+    MAX2871Bank(double refMHz, I_MAX2871BankTransport& transport, IDelayProvider& timing,
+                const MAX2871::max2871Registers& startupRegisters = MAX2871::defaultRegisters)
+        : _refMHz(refMHz), _transport(transport), _timing(timing), _startup(startupRegisters) {}
+
+    // Clean-clock startup of every chip at once (same sequence as MAX2871::reset)
+    void begin() {
+        const uint8_t all = (uint8_t)((1u << N) - 1);
+        for (uint8_t regAddr = 0; regAddr < 6; ++regAddr) {
+            for (uint8_t chip = 0; chip < N; ++chip) _curr[regAddr][chip] = _startup.Reg[regAddr];
+        }
+        writeWord(_startup.Reg[5], all);
+        _timing.delayMs(20);
+        writeWord(_startup.Reg[4] & 0xFFFFFEDF, all);           // RFOUTA and B disabled
+        for (int regAddr = 3; regAddr >= 0; --regAddr) writeWord(_startup.Reg[regAddr], all);
+        for (int regAddr = 5; regAddr >= 0; --regAddr) writeWord(_startup.Reg[regAddr], all);
+    }
+
+    // ---- Staged changes (programmed by update()) ----
+
+    void setFrequency(uint8_t chip, double freqMHz) {
+        MAX2871::fmnSolution sol;
+        MAX2871::solveFMN(_refMHz, freqMHz, sol);
+        setDividers(chip, sol.Frac, sol.M, sol.N, sol.DIVA);
+    }
+
+    void setFrequency(uint8_t chip, uint32_t fmn, uint8_t diva) {
+        setDividers(chip, (fmn >> 20) & 0xFFF, (fmn >> 8) & 0xFFF, fmn & 0xFF, diva);
+    }
+
+    void outputSelect(uint8_t chip, RFOutPort port) {
+        setField(4, chip, 8, 8, (port == RF_B || port == RF_ALL) ? 1u : 0u);
+        setField(4, chip, 5, 5, (port == RF_A || port == RF_ALL) ? 1u : 0u);
+    }
+
+    void outputPower(uint8_t chip, int dBm, RFOutPort port = RF_ALL) {
+        uint32_t code;
+        switch (dBm) {
+            case -4: code = 0u; break;
+            case -1: code = 1u; break;
+            case  2: code = 2u; break;
+            case  5: code = 3u; break;
+            default: return;                                    // leave power level unchanged
+        }
+        if (port == RF_A || port == RF_ALL) setField(4, chip, 4, 3, code);
+        if (port == RF_B || port == RF_ALL) setField(4, chip, 7, 6, code);
+    }
+
+    // ---- Programming ----
+
+    // Write what every chip needs, sharing identical words. Returns words sent.
+    uint8_t update() {
+        uint8_t need[6] = {0, 0, 0, 0, 0, 0};                   // chip mask per register
+        for (uint8_t chip = 0; chip < N; ++chip) {
+            MAX2871::max2871Registers target, written;
+            load(chip, _curr, target);
+            load(chip, _written, written);
+            uint8_t writes = MAX2871::requiredWrites(target, written);
+            for (uint8_t regAddr = 0; regAddr < 6; ++regAddr) {
+                if (writes & (1 << regAddr)) need[regAddr] |= (uint8_t)(1 << chip);
+            }
+        }
+        uint8_t words = 0;
+        for (int regAddr = 5; regAddr >= 0; --regAddr) {        // R0 last for every chip
+            uint8_t pending = need[regAddr];
+            while (pending) {
+                uint8_t first = 0;
+                while (!(pending & (1 << first))) ++first;
+                uint32_t word = _curr[regAddr][first];
+                uint8_t mask = 0;
+                for (uint8_t chip = first; chip < N; ++chip) {
+                    if ((pending & (1 << chip)) && _curr[regAddr][chip] == word) mask |= (uint8_t)(1 << chip);
+                }
+                writeWord(word, mask);
+                pending &= (uint8_t)~mask;
+                words++;
+            }
+        }
+        return words;
+    }
+
+    // ---- Status ----
+
+    bool isLocked(uint8_t chip) { return _transport.readMuxout(chip); }
+
+    uint32_t reg(uint8_t chip, uint8_t regAddr) const { return _curr[regAddr][chip]; }
+
+    double fmn2freq(uint8_t chip) const {
+        uint32_t n = (_curr[0][chip] >> 15) & 0xFFFF;
+        uint32_t frac = (_curr[0][chip] >> 3) & 0xFFF;
+        uint32_t m = (_curr[1][chip] >> 3) & 0xFFF;
+        uint8_t diva = (_curr[4][chip] >> 20) & 0x7;
+        return _refMHz * (n + (double)frac / (m ? m : 1)) / (1 << diva);
+    }
+
+private:
+    double _refMHz;                                     // Shared reference, R = 1
+    I_MAX2871BankTransport& _transport;
+    IDelayProvider& _timing;
+    MAX2871::max2871Registers _startup;                 // Copied: the argument may be a temporary
+    uint32_t _curr[6][N];                               // Register-major shadow images
+    uint32_t _written[6][N];                            // Last word latched by each chip
+
+    void load(uint8_t chip, const uint32_t (&src)[6][N], MAX2871::max2871Registers& regs) const {
+        for (uint8_t regAddr = 0; regAddr < 6; ++regAddr) regs.Reg[regAddr] = src[regAddr][chip];
+        regs.Reg[6] = 0;
+    }
+
+    void setDividers(uint8_t chip, uint16_t frac, uint16_t m, uint16_t n, uint8_t diva) {
+        if (chip >= N) return;
+        MAX2871::max2871Registers regs;
+        load(chip, _curr, regs);
+        MAX2871::dividersToImage(frac, m, n, diva, _startup, regs);
+        for (uint8_t regAddr = 0; regAddr < 6; ++regAddr) _curr[regAddr][chip] = regs.Reg[regAddr];
+    }
+
+    void setField(uint8_t regAddr, uint8_t chip, uint8_t bit_hi, uint8_t bit_lo, uint32_t value) {
+        if (chip >= N) return;
+        _curr[regAddr][chip] = (_curr[regAddr][chip] & ~bitMask(bit_hi, bit_lo)) | fieldValue(value, bit_hi, bit_lo);
+    }
+
+    void writeWord(uint32_t word, uint8_t leMask) {
+        _transport.spiWriteRegister(word, leMask);
+        for (uint8_t chip = 0; chip < N; ++chip) {
+            if (leMask & (1 << chip)) _written[word & 0x7][chip] = word;
+        }
+    }
+};
+
+#endif // MAX2871_BANK_H
@@ -0,0 +1,146 @@
+/* max2871_benchmark.h
+   (Tune-rate benchmark shared by every board and the native build)
+
+   Times the driver's hot paths through whatever transport it was built on
+   and prints one fixed-format line per operation. The harness only needs a
+   microsecond clock and a way to print text, so examples/benchmark runs the
+   same code on the Uno, Mega, Feather RP2040 and the PC:
+
+     max2871bench::Harness bench(lo, hal, micros, print);
+     bench.run("uno", 16);
+
+   Each operation runs 'reps' times between two clock reads; the per-op time
+   is the total divided by 'reps', so micros() steps of 4 us (AVR) are
+   averaged out. Operations alternate between two settings so no repetition
+   is skipped by the write rules.
+
+     # MAX2871 benchmark board=uno ref_mhz=66 reps=16
+     op=freq2FMN total_us=812344 ns_per_op=50771500 per_s=19
+     op=setFrequency total_us=... ns_per_op=... per_s=...
+     op=updateRegister ...           one changed register (R4)
+     op=updateAll ...                all six words, R5..R0
+     op=spiWriteRegister ...         one word straight to the transport
+     # done
+
+   For exact cycle counts on the Uno see extras/simulavr.
+
+   (c) 2025 Mark Stanley, GPL-3.0-or-later
+ */
+
+#ifndef MAX2871_BENCHMARK_H
+#define MAX2871_BENCHMARK_H
+
+#include <stdint.h>
+#include "max2871.h"
+
+namespace max2871bench {
+
+typedef uint32_t (*MicrosFn)();
+typedef void (*PrintFn)(const char* text);
+
+struct Result {
+    const char* name;
+    uint32_t totalUs;
+    uint32_t nsPerOp;
+    uint32_t perSecond;
+};
+
+class Harness {
+public:
+    static constexpr uint8_t NUM_OPS = 5;
+
+    Harness(MAX2871& lo, I_MAX2871Transport& transport, MicrosFn micros, PrintFn print)
+        : _lo(lo), _transport(transport), _micros(micros), _print(print) {}
+
+    // Times every operation and prints the report
+    void run(const char* board, uint16_t reps) {
+        if (reps == 0) reps = 1;
+        _print("# MAX2871 benchmark board=");
+        _print(board);
+        _print(" ref_mhz=");
+        printU32((uint32_t)(_lo.reference() + 0.5));
+        _print(" reps=");
+        printU32(reps);
+        _print("\n");
+        for (uint8_t i = 0; i < NUM_OPS; ++i) {
+            measure(i, reps);
+            const Result& r = _results[i];
+            _print("op=");
+            _print(r.name);
+            _print(" total_us=");
+            printU32(r.totalUs);
+            _print(" ns_per_op=");
+            printU32(r.nsPerOp);
+            _print(" per_s=");
+            printU32(r.perSecond);
+            _print("\n");
+        }
+        _print("# done\n");
+    }
+
+    const Result& result(uint8_t op) const { return _results[op]; }
+
+private:
+    MAX2871& _lo;
+    I_MAX2871Transport& _transport;
+    MicrosFn _micros;
+    PrintFn _print;
+    Result _results[NUM_OPS];
+
+    void op(uint8_t which, uint16_t i) {
+        switch (which) {
+        case 0:
+            _lo.freq2FMN((i & 1) ? 2400.0f : 4129.392f);
+            break;
+        case 1:
+            _lo.setFrequency((i & 1) ? 2450.0 : 2400.0);
+            break;
+        case 2:
+            _lo.outputPower((i & 1) ? +5 : +2, RF_ALL);
+            break;
+        case 3: {
+            uint32_t words[6];
+            for (uint8_t r = 0; r < 6; ++r) words[r] = _lo.Curr.Reg[5 - r];
+            _lo.writeWords(words, 6);
+            break;
+        }
+        default:
+            _transport.spiWriteRegister((i & 1) ? 0x00400005UL : 0x00C00005UL);
+            break;
+        }
+    }
+
+    static const char* name(uint8_t which) {
+        static const char* const names[NUM_OPS] = {
+            "freq2FMN", "setFrequency", "updateRegister", "updateAll", "spiWriteRegister"};
+        return names[which];
+    }
+
+    void measure(uint8_t which, uint16_t reps) {
+        op(which, 1);                                   // warm up, and start from the other setting
+        uint32_t t0 = _micros();
+        for (uint16_t i = 0; i < reps; ++i) op(which, i);
+        uint32_t total = _micros() - t0;
+
+        Result& r = _results[which];
+        r.name = name(which);
+        r.totalUs = total;
+        r.nsPerOp = total / reps * 1000UL + (total % reps) * 1000UL / reps;
+        r.perSecond = r.nsPerOp ? 1000000000UL / r.nsPerOp : 0;
+    }
+
+    void printU32(uint32_t v) {
+        char buf[11];
+        uint8_t i = sizeof(buf) - 1;
+        buf[i] = '\0';
+        do {
+            buf[--i] = (char)('0' + v % 10);
+            v /= 10;
+        } while (v);
+        _print(&buf[i]);
+    }
+};
+
+}  // namespace max2871bench
+
+#endif // MAX2871_BENCHMARK_H
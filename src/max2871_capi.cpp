@@ -0,0 +1,172 @@
+// Host-only: the C ABI is for PC builds of the library (see max2871_capi.h)
+#if !defined(ARDUINO)
+
+#include "max2871_capi.h"
+#include "max2871.h"
+#include "max2871_image.h"
+
+namespace {
+
+// In range, and N (VCO / reference) fits the solver's 8 bits
+bool validPoint(double refMHz, double freqMHz) {
+    return max2871image::validN(refMHz, freqMHz);
+}
+
+// The driver solves with fPFD = reference: R = 1, no doubler, no RDIV2
+int checkStart(const uint32_t* start, MAX2871::max2871Registers& image) {
+    image = MAX2871::defaultRegisters;
+    if (!start) return 0;
+    for (uint8_t r = 0; r < 6; ++r) {
+        if ((start[r] & 0x7) != r) return MAX2871_CAPI_E_IMAGE;
+        image.Reg[r] = start[r];
+    }
+    if ((start[2] & 0x03FFC000) > (1u << 14)) return MAX2871_CAPI_E_IMAGE;     // DBR, RDIV2, R[23:14] (0 reads as 1)
+    return 0;
+}
+
+// Collects a shadow driver's writes into the caller's array
+class WordSink : public I_MAX2871Transport, public IDelayProvider {
+public:
+    WordSink(uint32_t* words, size_t cap) : _words(words), _cap(cap), used(0), overflow(false) {}
+
+    void spiWriteRegister(uint32_t value) override {
+        if (used == _cap) {
+            overflow = true;
+            return;
+        }
+        _words[used++] = value;
+    }
+    bool readMuxout() override { return true; }
+    void delayMs(uint32_t) override {}
+
+private:
+    uint32_t* _words;
+    size_t _cap;
+
+public:
+    size_t used;
+    bool overflow;
+};
+
+}  // namespace
+
+extern "C" {
+
+uint32_t max2871_capi_version(void) {
+    return MAX2871_CAPI_VERSION;
+}
+
+int max2871_solve(double refMHz, const double* freqMHz, size_t count, uint32_t* fmn, uint8_t* diva) {
+    if (!freqMHz || !fmn || !diva) return MAX2871_CAPI_E_ARGS;
+    if (!max2871image::validReference(refMHz)) return MAX2871_CAPI_E_REFERENCE;
+    int outside = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (!validPoint(refMHz, freqMHz[i])) {
+            fmn[i] = 0;
+            diva[i] = 0xFF;
+            outside++;
+            continue;
+        }
+        MAX2871::fmnSolution sol;
+        MAX2871::solveFMN(refMHz, (float)freqMHz[i], sol);     // float target, as freq2FMN()
+        fmn[i] = MAX2871::packedFMN(sol);
+        diva[i] = sol.DIVA;
+    }
+    return outside;
+}
+
+int max2871_fmn_to_freq(double refMHz, const uint32_t* fmn, const uint8_t* diva, size_t count,
+                        double* freqMHz) {
+    if (!fmn || !diva || !freqMHz) return MAX2871_CAPI_E_ARGS;
+    if (!max2871image::validReference(refMHz)) return MAX2871_CAPI_E_REFERENCE;
+    for (size_t i = 0; i < count; ++i) {
+        uint16_t frac = (fmn[i] >> 20) & 0xFFF;
+        uint16_t m = (fmn[i] >> 8) & 0xFFF;
+        uint16_t n = fmn[i] & 0xFF;
+        double nDotF = n + (m ? (double)frac / m : 0.0);
+        freqMHz[i] = refMHz * nDotF / (1 << (diva[i] & 0x7));
+    }
+    return 0;
+}
+
+int max2871_images(double refMHz, const uint32_t* start, const double* freqMHz, size_t count,
+                   uint32_t* images) {
+    if (!freqMHz || !images) return MAX2871_CAPI_E_ARGS;
+    if (!max2871image::validReference(refMHz)) return MAX2871_CAPI_E_REFERENCE;
+    MAX2871::max2871Registers base;
+    int rc = checkStart(start, base);
+    if (rc) return rc;
+    int outside = 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t* out = images + 6 * i;
+        if (!validPoint(refMHz, freqMHz[i])) {
+            for (uint8_t r = 0; r < 6; ++r) out[r] = base.Reg[r];
+            out[0] = 0;
+            outside++;
+            continue;
+        }
+        MAX2871::fmnSolution sol;
+        MAX2871::solveFMN(refMHz, (float)freqMHz[i], sol);
+        MAX2871::max2871Registers regs = base;
+        MAX2871::dividersToImage(sol.Frac, sol.M, sol.N, sol.DIVA, base, regs);
+        for (uint8_t r = 0; r < 6; ++r) out[r] = regs.Reg[r];
+    }
+    return outside;
+}
+
+int max2871_image_to_freq(double refMHz, const uint32_t* images, size_t count, double* freqMHz) {
+    if (!images || !freqMHz) return MAX2871_CAPI_E_ARGS;
+    if (!max2871image::validReference(refMHz)) return MAX2871_CAPI_E_REFERENCE;
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t* reg = images + 6 * i;
+        for (uint8_t r = 0; r < 6; ++r) {
+            if ((reg[r] & 0x7) != r) return MAX2871_CAPI_E_IMAGE;
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t* reg = images + 6 * i;
+        uint32_t n = (reg[0] >> 15) & 0xFFFF;
+        uint32_t frac = (reg[0] >> 3) & 0xFFF;
+        uint32_t m = (reg[1] >> 3) & 0xFFF;
+        uint8_t diva = (reg[4] >> 20) & 0x7;
+        uint32_t r = (reg[2] >> 14) & 0x3FF;
+        if (r == 0) r = 1;
+        double fpfd = refMHz * (1 + ((reg[2] >> 25) & 1)) / (r * (1 + ((reg[2] >> 24) & 1)));
+        freqMHz[i] = fpfd * (n + (m ? (double)frac / m : 0.0)) / (1 << diva);
+    }
+    return 0;
+}
+
+/*  Runs the real driver against a capture transport, so the plan includes
+    everything setFrequency() does: write rules, integer-N mode switches,
+    the octave fast path.
+ */
+int max2871_plan_writes(double refMHz, const uint32_t* start, const double* freqMHz, size_t count,
+                        uint32_t* words, size_t wordCap, uint8_t* perPoint, size_t* used) {
+    if (!freqMHz || !words || !perPoint || !used) return MAX2871_CAPI_E_ARGS;
+    if (!max2871image::validReference(refMHz)) return MAX2871_CAPI_E_REFERENCE;
+    MAX2871::max2871Registers base;
+    int rc = checkStart(start, base);
+    if (rc) return rc;
+
+    WordSink sink(words, wordCap);
+    MAX2871 shadow(refMHz, sink, sink, base);
+    shadow.adoptImage(base);
+    int outside = 0;
+    for (size_t i = 0; i < count; ++i) {
+        size_t before = sink.used;
+        if (validPoint(refMHz, freqMHz[i])) shadow.setFrequency(freqMHz[i]);
+        else outside++;
+        if (sink.overflow) {
+            *used = before;
+            return MAX2871_CAPI_E_SPACE;
+        }
+        perPoint[i] = (uint8_t)(sink.used - before);
+    }
+    *used = sink.used;
+    return outside;
+}
+
+}  // extern "C"
+
+#endif  // !ARDUINO
@@ -0,0 +1,84 @@
+/* max2871_capi.h
+   (C ABI for host software: batch solving and register images)
+
+   PC tools that plan tunes need exactly the firmware's solver and register
+   encoding. Rather than porting them, build the driver sources as a shared
+   library ('make capi' -> .tools/libmax2871.so) and call these functions
+   from C, Python (ctypes/cffi), Rust, etc.
+
+   Conventions:
+   - everything works on caller-owned arrays of 'count' points
+   - 'fmn' is packed as MAX2871::setFrequency(fmn, diva) and the protocol's
+     SET_FMN expect: Frac[31:20] | M[19:8] | N[7:0]
+   - an image is the six words R0..R5; 'start' is the image the tunes are
+     applied to (NULL = the library's default startup image)
+   - the return value is 0 on success, a negative MAX2871_CAPI_E_* code for
+     bad arguments (nothing written), or the number of points the chip
+     cannot make at 'refMHz': outside 23.5-6000 MHz, or needing N > 255
+     (VCO / reference, 8 bits like the packed F/M/N). Those get fmn = 0,
+     diva = 0xFF, image R0 = 0 and no planned words; the others are still
+     solved
+   - the solver runs at fPFD = refMHz, so a 'start' image must have R = 1
+     and DBR = RDIV2 = 0 in R2, or the call returns E_IMAGE
+   - no global state: calls may run concurrently from several threads
+
+   This is plain C; the ABI is versioned with max2871_capi_version().
+
+   (c) 2025 Mark Stanley, GPL-3.0-or-later
+ */
+
+#ifndef MAX2871_CAPI_H
+#define MAX2871_CAPI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+  #define MAX2871_CAPI __declspec(dllexport)
+#else
+  #define MAX2871_CAPI __attribute__((visibility("default")))
+#endif
+
+#define MAX2871_CAPI_VERSION 1
+
+#define MAX2871_CAPI_E_ARGS      (-1)   /* NULL array or zero-sized output */
+#define MAX2871_CAPI_E_REFERENCE (-2)   /* reference outside 10-210 MHz */
+#define MAX2871_CAPI_E_IMAGE     (-3)   /* a word does not carry its own address, or start R2 divides fPFD */
+#define MAX2871_CAPI_E_SPACE     (-4)   /* 'words' too small for the write plan */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MAX2871_CAPI uint32_t max2871_capi_version(void);
+
+/* Frequencies to packed F/M/N and DIVA (the driver's solver) */
+MAX2871_CAPI int max2871_solve(double refMHz, const double* freqMHz, size_t count,
+                               uint32_t* fmn, uint8_t* diva);
+
+/* Packed F/M/N and DIVA back to output frequencies (fmn2freq) */
+MAX2871_CAPI int max2871_fmn_to_freq(double refMHz, const uint32_t* fmn, const uint8_t* diva,
+                                     size_t count, double* freqMHz);
+
+/* Frequencies to full images (6 words per point): what the driver's Curr
+   holds after setFrequency() from 'start' */
+MAX2871_CAPI int max2871_images(double refMHz, const uint32_t* start, const double* freqMHz,
+                                size_t count, uint32_t* images);
+
+/* Images back to output frequencies, honouring R, DBR and RDIV2 in R2 */
+MAX2871_CAPI int max2871_image_to_freq(double refMHz, const uint32_t* images, size_t count,
+                                       double* freqMHz);
+
+/* The exact words a driver holding 'start' writes for each point of a
+   sweep, in order (R5 first, R0 last per point), write rules applied.
+   'perPoint[i]' gets the number of words of point i; '*used' the total.
+   E_SPACE if 'wordCap' runs out. */
+MAX2871_CAPI int max2871_plan_writes(double refMHz, const uint32_t* start, const double* freqMHz,
+                                     size_t count, uint32_t* words, size_t wordCap,
+                                     uint8_t* perPoint, size_t* used);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MAX2871_CAPI_H */
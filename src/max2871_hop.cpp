@@ -0,0 +1,91 @@
+#include "max2871_hop.h"
+
+// ---- Hop table ----
+
+void MAX2871HopTable::spiWriteRegister(uint32_t value) {
+    if (_used == _wordCap) {
+        _full = true;
+        return;
+    }
+    _words[_used++] = value;
+}
+
+bool MAX2871HopTable::add(MAX2871& shadow, double freqMHz) {
+    if (_hops == _hopCap || _loop) return false;
+    MAX2871::max2871Registers before = shadow.Curr;
+    uint16_t start = _used;
+    _full = false;
+    shadow.setFrequency(freqMHz);
+    if (_full) {                                        // roll back: table and shadow as they were
+        _used = start;
+        shadow.adoptImage(before);
+        return false;
+    }
+    if (_hops == 0) _firstMHz = freqMHz;
+    _ends[_hops++] = _used;
+    return true;
+}
+
+/*  The closing hop returns the chip to the state the first hop left it in,
+    so on later passes it stands in for hop 0 and playback goes on with hop 1.
+ */
+bool MAX2871HopTable::closeLoop(MAX2871& shadow) {
+    if (_hops < 2 || _loop) return false;
+    if (!add(shadow, _firstMHz)) return false;
+    _loop = true;
+    return true;
+}
+
+// ---- Playback ----
+
+void MAX2871HopPlayer::start(uint32_t nowUs, uint32_t periodUs, uint32_t lateUs) {
+    _running = false;
+    _next = 0;
+    _periodUs = periodUs ? periodUs : 1;
+    _lateUs = lateUs;
+    _dueUs = nowUs;
+    resetStats();
+    _running = _table.hops() > 0;
+}
+
+void MAX2871HopPlayer::resetStats() {
+    _stats.played = 0;
+    _stats.late = 0;
+    _stats.missed = 0;
+    _stats.maxLateUs = 0;
+    _stats.minIntervalUs = 0xFFFFFFFFUL;
+    _stats.maxIntervalUs = 0;
+}
+
+/*  Keep this path short: it may run in an ISR. Time differences are taken
+    as signed 32-bit values so the comparison survives the micros() wrap.
+ */
+bool MAX2871HopPlayer::tick(uint32_t nowUs) {
+    if (!_running) return false;
+    int32_t lateness = (int32_t)(nowUs - _dueUs);
+    if (lateness < 0) return false;                     // not due yet
+
+    _transport.spiWriteRegisters(_table.hopWords(_next), _table.hopLength(_next));
+
+    uint32_t late = (uint32_t)lateness;
+    if (_stats.played) {
+        uint32_t interval = nowUs - _lastUs;
+        if (interval < _stats.minIntervalUs) _stats.minIntervalUs = interval;
+        if (interval > _stats.maxIntervalUs) _stats.maxIntervalUs = interval;
+    }
+    _stats.played++;
+    _lastUs = nowUs;
+    if (late > _lateUs) _stats.late++;
+    if (late > _stats.maxLateUs) _stats.maxLateUs = late;
+    _dueUs += _periodUs;
+    if (late >= _periodUs) {                            // next slot already started
+        _stats.missed++;
+        _dueUs += (late / _periodUs) * _periodUs;       // back onto the grid
+    }
+
+    if (++_next == _table.hops()) {
+        if (_table.looped()) _next = 1;                 // the closing hop was hop 0
+        else _running = false;
+    }
+    return true;
+}
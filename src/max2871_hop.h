@@ -0,0 +1,122 @@
+/* max2871_hop.h
+   (Precompiled hop tables and timer-driven playback)
+
+   Frequency-hopping tests need hops on a fixed cadence (e.g. every 100 us),
+   which leaves no time for the solver. The hop list is therefore compiled
+   ahead of time, by the driver itself, into the exact words each hop writes:
+
+     uint32_t words[300];
+     uint16_t ends[100];
+     MAX2871HopTable table(words, 300, ends, 100);
+     MAX2871 shadow(66.0, table, table);     // writes land in the table
+     shadow.adoptImage(lo.Curr);             // start from what the chip holds
+     for (i = 0; i < n; i++) table.add(shadow, hops[i]);
+     table.closeLoop(shadow);                // optional: last hop back to the first
+
+     MAX2871HopPlayer player(transport, table);
+     player.start(micros(), 100);            // 100 us per hop
+     // timer ISR, or a tight loop:
+     player.tick(micros());
+
+     lo.adoptImage(shadow.Curr);             // after playback, if stopped on the last hop
+
+   tick() compares the time with the next hop's slot and, when it is due,
+   hands that hop's words to the transport as one batch. Nothing else runs
+   there: no solver, no float math, no allocation. Slots are fixed on the
+   grid set by start(), so a late hop does not push the ones after it. A hop
+   written after the next slot has started counts as missed, and the grid is
+   moved on by the missed periods so playback does not write a backlog of
+   hops back to back.
+
+   Times are in microseconds, modulo 2^32 (micros() wraps after ~71 minutes).
+
+   (c) 2025 Mark Stanley, GPL-3.0-or-later
+ */
+
+#ifndef MAX2871_HOP_H
+#define MAX2871_HOP_H
+
+#include <stdint.h>
+#include "max2871.h"
+
+/*  The words every hop writes, stored back to back. It is the transport of a
+    shadow MAX2871, so add() gets exactly what setFrequency() would send,
+    write rules and fast paths included.
+ */
+class MAX2871HopTable : public I_MAX2871Transport, public IDelayProvider {
+public:
+    MAX2871HopTable(uint32_t* words, uint16_t wordCap, uint16_t* ends, uint16_t hopCap)
+        : _words(words), _ends(ends), _wordCap(wordCap), _hopCap(hopCap),
+          _used(0), _hops(0), _loop(false), _full(false), _firstMHz(0) {}
+
+    // Compile one hop. False when either buffer is full; the table is unchanged.
+    bool add(MAX2871& shadow, double freqMHz);
+    // Append the hop from the last point back to the first, so playback can repeat
+    bool closeLoop(MAX2871& shadow);
+    void clear() { _used = 0; _hops = 0; _loop = false; }
+
+    uint16_t hops() const { return _hops; }
+    uint16_t words() const { return _used; }
+    bool looped() const { return _loop; }
+
+    const uint32_t* hopWords(uint16_t hop) const { return _words + (hop ? _ends[hop - 1] : 0); }
+    uint8_t hopLength(uint16_t hop) const { return (uint8_t)(_ends[hop] - (hop ? _ends[hop - 1] : 0)); }
+
+    // Capture side, used by the shadow driver
+    void spiWriteRegister(uint32_t value) override;
+    bool readMuxout() override { return true; }
+    void delayMs(uint32_t) override {}
+
+private:
+    uint32_t* _words;
+    uint16_t* _ends;                    // end offset of each hop in _words
+    uint16_t _wordCap;
+    uint16_t _hopCap;
+    uint16_t _used;
+    uint16_t _hops;
+    bool _loop;
+    bool _full;
+    double _firstMHz;
+};
+
+class MAX2871HopPlayer {
+public:
+    struct Stats {
+        uint32_t played;
+        uint32_t late;                  // written more than 'lateUs' after their slot
+        uint32_t missed;                // written after the next slot had started
+        uint32_t maxLateUs;
+        uint32_t minIntervalUs;         // between consecutive hop writes
+        uint32_t maxIntervalUs;
+        uint32_t jitterUs() const { return played > 1 ? maxIntervalUs - minIntervalUs : 0; }
+    };
+
+    MAX2871HopPlayer(I_MAX2871Transport& transport, const MAX2871HopTable& table)
+        : _transport(transport), _table(table), _running(false), _next(0),
+          _periodUs(0), _lateUs(0), _dueUs(0), _lastUs(0) { resetStats(); }
+
+    // First hop is due at 'nowUs'. A table with closeLoop() repeats until stop().
+    void start(uint32_t nowUs, uint32_t periodUs, uint32_t lateUs = 0);
+    void stop() { _running = false; }
+
+    // Call from the timer ISR or a polling loop. True when a hop was written.
+    bool tick(uint32_t nowUs);
+
+    bool running() const { return _running; }
+    uint16_t nextHop() const { return _next; }
+    const Stats& stats() const { return _stats; }
+    void resetStats();
+
+private:
+    I_MAX2871Transport& _transport;
+    const MAX2871HopTable& _table;
+    volatile bool _running;
+    uint16_t _next;
+    uint32_t _periodUs;
+    uint32_t _lateUs;
+    uint32_t _dueUs;
+    uint32_t _lastUs;
+    Stats _stats;
+};
+
+#endif // MAX2871_HOP_H
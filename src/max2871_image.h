@@ -0,0 +1,199 @@
+/* max2871_image.h
+   (Compile-time register image builder)
+
+   Builds a complete max2871Registers image for a fixed frequency at compile
+   time, so fixed-frequency products can boot straight into the right image
+   without running the solver:
+
+     MAX2871_STATIC_IMAGE(loImage, 66.0, 1420.0, RF_A, +2);
+     MAX2871 lo(66.0, hal, hal, loImage);
+
+   The F/M/N/DIVA search mirrors MAX2871::solveFMN() step for step, using
+   the same float/double mix, so the image is bit-identical to what
+   setFrequency() produces at run time. Only C++11 constexpr is used (one
+   return statement per function) because that is what the AVR toolchain
+   compiles by default. The M search splits the range in halves to keep
+   the recursion depth around a dozen calls.
+
+   (c) 2025 Mark Stanley, GPL-3.0-or-later
+ */
+
+#ifndef MAX2871_IMAGE_H
+#define MAX2871_IMAGE_H
+
+#include <stdint.h>
+#include "max2871.h"
+
+// Not constexpr on purpose: reaching one of these during constant evaluation
+// turns an illegal builder argument into a compile error that names the problem.
+void max2871_image_illegal_reference();
+void max2871_image_illegal_frequency();
+void max2871_image_illegal_power();
+void max2871_image_illegal_n();
+
+namespace max2871image {
+
+// Bits that are not derived from the frequency or output arguments. These are
+// the hand-tuned words from the Spectrum Analyzer RF board with N, F, M, DIVA,
+// the RF output enables and the output power fields cleared.
+static constexpr uint32_t TEMPLATE_R0 = 0x00000000;
+static constexpr uint32_t TEMPLATE_R1 = 0x40010001;
+static constexpr uint32_t TEMPLATE_R2 = 0x80005F42;
+static constexpr uint32_t TEMPLATE_R3 = 0x00001F23;
+static constexpr uint32_t TEMPLATE_R4 = 0x638E8004;
+static constexpr uint32_t TEMPLATE_R5 = 0x00400005;
+
+// ---- Argument checks (usable in static_assert) ----
+
+constexpr bool validReference(double refMHz) {
+    return refMHz >= 10.0 && refMHz <= 210.0;           // REFIN range, R = 1
+}
+
+constexpr bool validFrequency(double freqMHz) {
+    return freqMHz >= 23.5 && freqMHz <= 6000.0;
+}
+
+constexpr bool validPower(int dBm) {
+    return dBm == -4 || dBm == -1 || dBm == 2 || dBm == 5;
+}
+
+// validN(), for the reference/frequency pair, follows the solver below
+
+// ---- Field helpers ----
+
+constexpr uint32_t mask(uint8_t hi, uint8_t lo) {
+    return (0xFFFFFFFFu >> (31 - (hi - lo))) << lo;
+}
+
+constexpr uint32_t setField(uint32_t word, uint8_t hi, uint8_t lo, uint32_t value) {
+    return (word & ~mask(hi, lo)) | ((value << lo) & mask(hi, lo));
+}
+
+constexpr uint32_t powerCode(int dBm) {
+    return dBm == -4 ? 0u : dBm == -1 ? 1u : dBm == 2 ? 2u : 3u;
+}
+
+// ---- Solver (same arithmetic as MAX2871::solveFMN) ----
+
+constexpr float absf(float x) { return x < 0 ? -x : x; }
+
+constexpr float vcoFor(float f) { return f < 3000.0 ? vcoFor(f * 2) : f; }
+
+constexpr uint8_t divaFor(float f, uint8_t diva) {
+    return f < 3000.0 ? divaFor(f * 2, diva + 1) : diva;
+}
+
+constexpr float nDotF(double Fpfd, float target) {
+    return static_cast<float>(vcoFor(target) / Fpfd);
+}
+
+constexpr uint16_t nFor(double Fpfd, float target) {
+    return static_cast<uint8_t>(nDotF(Fpfd, target));
+}
+
+// N is 8 bits in solveFMN() and in the packed F/M/N words, so VCO / reference
+// must stay below 256 (references under ~23.5 MHz cannot reach the top of the VCO)
+constexpr bool validN(double refMHz, double freqMHz) {
+    return validReference(refMHz) && validFrequency(freqMHz) &&
+           nDotF(refMHz, static_cast<float>(freqMHz)) < 256.0f;
+}
+
+constexpr float fracOf(double Fpfd, float target) {
+    return nDotF(Fpfd, target) - nFor(Fpfd, target);
+}
+
+constexpr float fFor(float frac, uint16_t M) {
+    return static_cast<uint16_t>(frac * float(M));
+}
+
+constexpr float errFor(double Fpfd, float target, uint16_t M) {
+    return absf(vcoFor(target) - static_cast<float>(
+        Fpfd * (nFor(Fpfd, target) + fFor(fracOf(Fpfd, target), M) / M)));
+}
+
+struct Candidate {
+    float err;
+    uint16_t M;
+    constexpr Candidate(float e, uint16_t m) : err(e), M(m) {}
+};
+
+// Smallest error; ties go to the smaller M like the descending '<=' search
+constexpr Candidate better(Candidate a, Candidate b) {
+    return a.err < b.err ? a : b.err < a.err ? b : (a.M < b.M ? a : b);
+}
+
+constexpr Candidate bestM(double Fpfd, float target, uint16_t lo, uint16_t hi) {
+    return lo == hi ? Candidate(errFor(Fpfd, target, lo), lo)
+                    : better(bestM(Fpfd, target, lo, lo + (hi - lo) / 2),
+                             bestM(Fpfd, target, lo + (hi - lo) / 2 + 1, hi));
+}
+
+constexpr uint16_t orElse(uint16_t a, uint16_t b) { return a ? a : b; }
+
+// Largest M with zero error, where the run-time search stops early (0 if none)
+constexpr uint16_t exactM(double Fpfd, float target, uint16_t lo, uint16_t hi) {
+    return lo == hi ? (errFor(Fpfd, target, lo) == 0 ? lo : 0)
+                    : orElse(exactM(Fpfd, target, lo + (hi - lo) / 2 + 1, hi),
+                             exactM(Fpfd, target, lo, lo + (hi - lo) / 2));
+}
+
+constexpr uint16_t pickM(double Fpfd, float target, uint16_t exact) {
+    return exact ? exact : bestM(Fpfd, target, 2, 4095).M;
+}
+
+constexpr uint16_t mFor(double Fpfd, float target) {
+    return pickM(Fpfd, target, exactM(Fpfd, target, 2, 4095));
+}
+
+// ---- Image assembly ----
+
+// Integer-N mode fields, as MAX2871::dividersToImage() sets them for F = 0
+constexpr uint32_t intR0(uint32_t r0, uint16_t F) { return setField(r0, 31, 31, F == 0 ? 1u : 0u); }
+constexpr uint32_t intR1(uint32_t r1, uint16_t F) { return F == 0 ? setField(r1, 30, 29, 0) : r1; }
+constexpr uint32_t intR2(uint32_t r2, uint16_t F) { return F == 0 ? setField(r2, 8, 7, 3) : r2; }
+
+constexpr MAX2871::max2871Registers assemble(uint16_t N, uint16_t F, uint16_t M,
+                                             uint8_t diva, RFOutPort outputs, int dBm) {
+    return MAX2871::max2871Registers{{
+        intR0(setField(setField(TEMPLATE_R0, 30, 15, N), 14, 3, F), F),
+        intR1(setField(TEMPLATE_R1, 14, 3, M), F),
+        intR2(TEMPLATE_R2, F),
+        TEMPLATE_R3,
+        setField(setField(setField(setField(setField(TEMPLATE_R4,
+            22, 20, diva),
+            8, 8, (outputs & RF_B) ? 1u : 0u),
+            7, 6, powerCode(dBm)),
+            5, 5, (outputs & RF_A) ? 1u : 0u),
+            4, 3, powerCode(dBm)),
+        TEMPLATE_R5,
+        0
+    }};
+}
+
+constexpr MAX2871::max2871Registers buildChecked(double Fpfd, float target, RFOutPort outputs, int dBm) {
+    return assemble(nFor(Fpfd, target),
+                    fFor(fracOf(Fpfd, target), mFor(Fpfd, target)),
+                    mFor(Fpfd, target), divaFor(target, 0), outputs, dBm);
+}
+
+// Image for 'freqMHz' from a 'refMHz' reference, with the chosen outputs at 'dBm'
+constexpr MAX2871::max2871Registers build(double refMHz, double freqMHz,
+                                          RFOutPort outputs = RF_ALL, int dBm = 5) {
+    return !validReference(refMHz) ? (max2871_image_illegal_reference(), buildChecked(66.0, 60.0f, outputs, 5))
+         : !validFrequency(freqMHz) ? (max2871_image_illegal_frequency(), buildChecked(refMHz, 60.0f, outputs, 5))
+         : !validPower(dBm) ? (max2871_image_illegal_power(), buildChecked(refMHz, 60.0f, outputs, 5))
+         : !validN(refMHz, freqMHz) ? (max2871_image_illegal_n(), buildChecked(66.0, 60.0f, outputs, 5))
+         : buildChecked(refMHz, static_cast<float>(freqMHz), outputs, dBm);
+}
+
+} // namespace max2871image
+
+// Declare a compile-time image with readable diagnostics for bad arguments
+#define MAX2871_STATIC_IMAGE(name, refMHz, freqMHz, outputs, dBm)                               \
+    static_assert(max2871image::validReference(refMHz), "MAX2871: reference must be 10..210 MHz"); \
+    static_assert(max2871image::validFrequency(freqMHz), "MAX2871: frequency must be 23.5..6000 MHz"); \
+    static_assert(max2871image::validPower(dBm), "MAX2871: power must be -4, -1, +2 or +5 dBm");   \
+    static_assert(max2871image::validN(refMHz, freqMHz), "MAX2871: N over 255, reference too low for this frequency"); \
+    static constexpr MAX2871::max2871Registers name = max2871image::build(refMHz, freqMHz, outputs, dBm)
+
+#endif // MAX2871_IMAGE_H
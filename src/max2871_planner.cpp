@@ -0,0 +1,78 @@
+#include "max2871_planner.h"
+#include "max2871_image.h"
+#include <math.h>
+
+MAX2871RefPlanner::MAX2871RefPlanner(MAX2871& lo, double ref1MHz, double ref2MHz, float toleranceHz)
+    : _lo(lo),
+      _toleranceHz(toleranceHz),
+      _active(lo.reference() == ref2MHz ? 1 : 0),
+      _select(nullptr),
+      _selectCtx(nullptr) {
+    _refMHz[0] = ref1MHz;
+    _refMHz[1] = ref2MHz;
+}
+
+void MAX2871RefPlanner::candidate(uint8_t ref, double freqMHz, Plan& plan) const {
+    plan.ref = ref & 1;
+    double Fpfd = _refMHz[plan.ref];                    // R = 1, as in freq2FMN()
+
+    // N is 8 bits: a reference too low for this VCO cannot be programmed
+    plan.valid = max2871image::validN(Fpfd, freqMHz);
+    if (!plan.valid) {
+        plan.sol.Frac = plan.sol.M = plan.sol.N = 0;
+        plan.sol.DIVA = 0;
+        plan.errorHz = INFINITY;
+        plan.integerN = false;
+        plan.writes = 0;
+        return;
+    }
+    MAX2871::solveFMN(Fpfd, freqMHz, plan.sol);
+    const MAX2871::fmnSolution& s = plan.sol;
+
+    double fout = Fpfd * (s.N + (double)s.Frac / s.M) / (1 << s.DIVA);
+    plan.errorHz = fabs(fout - freqMHz) * 1e6;
+    plan.integerN = s.Frac == 0;
+
+    // A reference change always costs R0 (VCO re-selection), on top of the tune itself
+    uint8_t mask = _lo.writeMask(MAX2871::packedFMN(s), s.DIVA);
+    if (plan.ref != _active) mask |= 1;
+    plan.writes = 0;
+    for (; mask; mask &= mask - 1) plan.writes++;
+}
+
+bool MAX2871RefPlanner::better(const Plan& a, const Plan& b) const {
+    if (a.valid != b.valid) return a.valid;
+    bool aOk = a.errorHz <= _toleranceHz;
+    bool bOk = b.errorHz <= _toleranceHz;
+    if (aOk != bOk) return aOk;
+    if (!aOk) return a.errorHz < b.errorHz;
+    if (a.integerN != b.integerN) return a.integerN;
+    if (a.writes != b.writes) return a.writes < b.writes;
+    if (a.sol.M != b.sol.M) return a.sol.M < b.sol.M;
+    return a.errorHz < b.errorHz;
+}
+
+bool MAX2871RefPlanner::plan(double freqMHz, Plan& best) const {
+    Plan other;
+    candidate(_active, freqMHz, best);                  // ties keep the current reference
+    candidate(_active ^ 1, freqMHz, other);
+    if (better(other, best)) best = other;
+    return best.valid;
+}
+
+uint8_t MAX2871RefPlanner::apply(const Plan& plan) {
+    if (!plan.valid) return _active;                    // nothing to program
+    if (plan.ref != _active) {
+        if (_select) _select(plan.ref, _selectCtx);     // switch the clock before R0 goes out
+        _active = plan.ref;
+    }
+    _lo.setReference(_refMHz[_active]);
+    _lo.setFrequency(MAX2871::packedFMN(plan.sol), plan.sol.DIVA);
+    return _active;
+}
+
+uint8_t MAX2871RefPlanner::setFrequency(double freqMHz) {
+    Plan best;
+    plan(freqMHz, best);
+    return apply(best);
+}
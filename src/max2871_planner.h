@@ -0,0 +1,72 @@
+/* max2871_planner.h
+   (Dual-reference frequency planner)
+
+   The RF board has two reference clocks, selected with REF_EN1/REF_EN2.
+   For each target the planner solves F/M/N/DIVA against both and keeps the
+   cheaper one:
+
+     1. error within 'toleranceHz' (otherwise: smallest error wins)
+     2. integer-N (Frac = 0) - faster, cleaner lock
+     3. fewest register words to write from the current state
+     4. smallest M
+     5. smallest error
+
+   apply() calls the reference-select hook when the reference changes, so
+   the board can flip REF_EN1/REF_EN2 before the new words go out, then moves
+   the driver onto the new Fpfd without reconstructing it.
+
+     MAX2871RefPlanner planner(lo, 66.0, 60.0);
+     planner.setReferenceSelect(selectRef, nullptr);   // drives REF_EN1/REF_EN2
+     planner.setFrequency(2400.0);
+
+   Each plan runs the solver twice, so it costs twice a setFrequency() solve.
+   A reference that needs N over 255 for the target (VCO / reference >= 256)
+   is never picked; when neither can reach it, nothing is written.
+
+   (c) 2025 Mark Stanley, GPL-3.0-or-later
+ */
+
+#ifndef MAX2871_PLANNER_H
+#define MAX2871_PLANNER_H
+
+#include <stdint.h>
+#include "max2871.h"
+
+class MAX2871RefPlanner {
+public:
+    // Called with 0 (REF_EN1) or 1 (REF_EN2) when the reference must change
+    typedef void (*RefSelectFn)(uint8_t ref, void* ctx);
+
+    struct Plan {
+        uint8_t ref;                    // 0 = REF_EN1, 1 = REF_EN2
+        MAX2871::fmnSolution sol;
+        float errorHz;
+        uint8_t writes;                 // register words the tune will cost
+        bool integerN;
+        bool valid;                     // N fits 8 bits at this reference
+    };
+
+    MAX2871RefPlanner(MAX2871& lo, double ref1MHz, double ref2MHz, float toleranceHz = 1000.0f);
+
+    void setReferenceSelect(RefSelectFn select, void* ctx) { _select = select; _selectCtx = ctx; }
+
+    void candidate(uint8_t ref, double freqMHz, Plan& plan) const;   // one reference
+    bool plan(double freqMHz, Plan& best) const;                      // best of both, false if neither
+    uint8_t apply(const Plan& plan);                                  // returns the reference in use (no-op if !valid)
+    uint8_t setFrequency(double freqMHz);                             // plan + apply
+
+    uint8_t activeReference() const { return _active; }
+    double referenceMHz(uint8_t ref) const { return _refMHz[ref & 1]; }
+
+private:
+    MAX2871& _lo;
+    double _refMHz[2];
+    float _toleranceHz;
+    uint8_t _active;
+    RefSelectFn _select;
+    void* _selectCtx;
+
+    bool better(const Plan& a, const Plan& b) const;
+};
+
+#endif // MAX2871_PLANNER_H
@@ -0,0 +1,271 @@
+#include "max2871_protocol.h"
+#include "max2871.h"
+#include "max2871_stream.h"
+
+namespace max2871proto {
+
+// ---- Framing ----
+
+uint8_t crc8(uint8_t crc, const uint8_t* data, size_t len) {
+    while (len--) {
+        crc ^= *data++;
+        for (uint8_t bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+size_t encode(uint8_t* out, size_t cap, uint8_t cmd, const uint8_t* payload, uint8_t len) {
+    if (len > MAX2871_PROTO_MAX_PAYLOAD || cap < (size_t)len + OVERHEAD) return 0;
+    out[0] = SOF;
+    out[1] = cmd;
+    out[2] = len;
+    for (uint8_t i = 0; i < len; ++i) out[3 + i] = payload[i];
+    out[3 + len] = crc8(0, out + 1, len + 2);
+    return len + OVERHEAD;
+}
+
+Parser::Result Parser::feed(uint8_t byte) {
+    switch (_state) {
+        case WAIT_SOF:
+            if (byte == SOF) _state = GET_CMD;
+            return NEED_MORE;
+
+        case GET_CMD:
+            _frame.cmd = byte;
+            _crc = crc8(0, &byte, 1);
+            _state = GET_LEN;
+            return NEED_MORE;
+
+        case GET_LEN:
+            if (byte > MAX2871_PROTO_MAX_PAYLOAD) {
+                _errors++;
+                reset();
+                return FRAME_ERROR;
+            }
+            _frame.len = byte;
+            _frame.payload = _buf;
+            _crc = crc8(_crc, &byte, 1);
+            _count = 0;
+            _state = byte ? GET_PAYLOAD : GET_CRC;
+            return NEED_MORE;
+
+        case GET_PAYLOAD:
+            _buf[_count++] = byte;
+            if (_count == _frame.len) {
+                _crc = crc8(_crc, _buf, _frame.len);
+                _state = GET_CRC;
+            }
+            return NEED_MORE;
+
+        case GET_CRC:
+            reset();
+            if (byte != _crc) {
+                _errors++;
+                return FRAME_ERROR;
+            }
+            return FRAME_READY;
+    }
+    return NEED_MORE;
+}
+
+// ---- Device side ----
+
+// 23.5-6000 MHz: below, DIVA overflows (0 never reaches the VCO range); above, N is bogus
+static bool validKHz(uint32_t kHz) {
+    return kHz >= 23500UL && kHz <= 6000000UL;
+}
+
+size_t Handler::handle(const Frame& frame, uint8_t* reply, size_t cap) {
+    uint8_t out[7];
+    uint8_t outLen = 2;
+    out[0] = STATUS_OK;
+    out[1] = 0;
+
+    switch (frame.cmd) {
+        case CMD_TUNE:
+            outLen = 1;
+            if (frame.len != 4) {
+                out[0] = STATUS_BAD_LENGTH;
+                break;
+            }
+            if (!validKHz(getU32(frame.payload))) {
+                out[0] = STATUS_BAD_VALUE;
+                break;
+            }
+            _lo.setFrequency(getU32(frame.payload) / 1000.0);
+            break;
+
+        case CMD_TUNE_LIST:
+            if (frame.len == 0 || frame.len % 4) {
+                out[0] = STATUS_BAD_LENGTH;
+                break;
+            }
+            for (uint8_t i = 0; i < frame.len / 4; ++i) {
+                uint32_t kHz = getU32(frame.payload + 4 * i);
+                if (!validKHz(kHz)) {
+                    out[0] = STATUS_BAD_VALUE;
+                    break;
+                }
+                _lo.setFrequency(kHz / 1000.0);
+                out[1] = i + 1;
+                point(i);
+            }
+            break;
+
+        case CMD_TUNE_FMN:
+            if (frame.len == 0 || frame.len % 5) {
+                out[0] = STATUS_BAD_LENGTH;
+                break;
+            }
+            for (uint8_t i = 0; i < frame.len / 5; ++i) {
+                const uint8_t* p = frame.payload + 5 * i;
+                if (p[4] > 7) {
+                    out[0] = STATUS_BAD_VALUE;
+                    break;
+                }
+                _lo.setFrequency(getU32(p), p[4]);
+                out[1] = i + 1;
+                point(i);
+            }
+            break;
+
+        case CMD_REG_WRITE:
+            if (frame.len == 0 || frame.len % 4) {
+                out[0] = STATUS_BAD_LENGTH;
+                break;
+            }
+            for (uint8_t i = 0; i < frame.len / 4; ++i) {
+                uint32_t word = getU32(frame.payload + 4 * i);
+                if ((word & 0x7) > 5) {
+                    out[0] = STATUS_BAD_VALUE;
+                    break;
+                }
+                _lo.setRegister(word);
+                out[1] = i + 1;
+            }
+            break;
+
+        case CMD_STREAM: {
+            if (!_stream) {
+                outLen = 1;
+                out[0] = STATUS_BAD_COMMAND;
+                break;
+            }
+            outLen = 3;
+            max2871stream::Decoder decoder(*_stream);
+            decoder.begin(_lo.Curr.Reg);
+            decoder.setPointHook(streamPoint, this);
+            bool ok = decoder.feed(frame.payload, frame.len) >= 0;
+
+            // Whatever was played is on the chip now; keep the driver in step
+            MAX2871::max2871Registers image = _lo.Curr;
+            for (uint8_t r = 0; r < 6; ++r) image.Reg[r] = decoder.image()[r];
+            if (!_lo.adoptImage(image) || !ok) out[0] = STATUS_BAD_VALUE;
+            out[1] = (uint8_t)decoder.points();
+            out[2] = (uint8_t)(decoder.points() >> 8);
+            break;
+        }
+
+        case CMD_STATUS:
+            outLen = 7;
+            out[1] = _lo.isLocked() ? 1 : 0;
+            putU32(out + 2, _lo.packedFMN());
+            out[6] = _lo.DIVA;
+            break;
+
+        default:
+            outLen = 1;
+            out[0] = STATUS_BAD_COMMAND;
+            break;
+    }
+    return encode(reply, cap, frame.cmd | REPLY, out, outLen);
+}
+
+// ---- Host side ----
+
+bool Client::transact(uint8_t cmd, const uint8_t* payload, uint8_t len, Reply& reply) {
+    uint8_t frame[MAX_FRAME];
+    size_t n = encode(frame, sizeof(frame), cmd, payload, len);
+    if (n == 0 || _write(frame, n, _ctx) != n) return false;
+
+    _parser.reset();
+    for (;;) {
+        int c = _read(_ctx);
+        if (c < 0) return false;
+        if (_parser.feed((uint8_t)c) != Parser::FRAME_READY) continue;
+
+        const Frame& f = _parser.frame();
+        if (f.cmd != (cmd | REPLY) || f.len < 1) continue;     // not ours, keep listening
+        reply.status = f.payload[0];
+        reply.count = f.len > 1 ? f.payload[1] : 0;
+        if (cmd == CMD_STREAM && f.len == 3) reply.count |= (uint16_t)(f.payload[2] << 8);
+        reply.locked = false;
+        reply.fmn = 0;
+        reply.diva = 0;
+        if (cmd == CMD_STATUS && f.len == 7) {
+            reply.locked = f.payload[1] != 0;
+            reply.fmn = getU32(f.payload + 2);
+            reply.diva = f.payload[6];
+        }
+        return true;
+    }
+}
+
+bool Client::tune(double freqMHz, Reply& reply) {
+    uint8_t p[4];
+    putU32(p, mhzToKHz(freqMHz));
+    return transact(CMD_TUNE, p, sizeof(p), reply);
+}
+
+bool Client::tuneList(const double* freqMHz, uint8_t count, Reply& reply) {
+    uint8_t p[MAX2871_PROTO_MAX_PAYLOAD];
+    if (count == 0 || count > sizeof(p) / 4) return false;
+    for (uint8_t i = 0; i < count; ++i) putU32(p + 4 * i, mhzToKHz(freqMHz[i]));
+    return transact(CMD_TUNE_LIST, p, count * 4, reply);
+}
+
+bool Client::tuneFMN(const uint32_t* fmn, const uint8_t* diva, uint8_t count, Reply& reply) {
+    uint8_t p[MAX2871_PROTO_MAX_PAYLOAD];
+    if (count == 0 || count > sizeof(p) / 5) return false;
+    for (uint8_t i = 0; i < count; ++i) {
+        putU32(p + 5 * i, fmn[i]);
+        p[5 * i + 4] = diva[i];
+    }
+    return transact(CMD_TUNE_FMN, p, count * 5, reply);
+}
+
+bool Client::writeRegisters(const uint32_t* words, uint8_t count, Reply& reply) {
+    uint8_t p[MAX2871_PROTO_MAX_PAYLOAD];
+    if (count == 0 || count > sizeof(p) / 4) return false;
+    for (uint8_t i = 0; i < count; ++i) putU32(p + 4 * i, words[i]);
+    return transact(CMD_REG_WRITE, p, count * 4, reply);
+}
+
+bool Client::status(Reply& reply) {
+    return transact(CMD_STATUS, nullptr, 0, reply);
+}
+
+bool Client::stream(const uint8_t* records, size_t len, Reply& reply) {
+    uint16_t total = 0;
+    size_t pos = 0;
+    while (pos < len) {
+        size_t chunk = 0;
+        for (;;) {
+            size_t n = max2871stream::recordLength(records + pos + chunk, len - pos - chunk);
+            if (n == 0 || chunk + n > MAX2871_PROTO_MAX_PAYLOAD) break;
+            chunk += n;
+            if (pos + chunk == len) break;
+        }
+        if (chunk == 0) return false;               // truncated, or a record larger than a frame
+        if (!transact(CMD_STREAM, records + pos, (uint8_t)chunk, reply)) return false;
+        total += reply.count;
+        if (reply.status != STATUS_OK) break;
+        pos += chunk;
+    }
+    reply.count = total;
+    return true;
+}
+
+} // namespace max2871proto
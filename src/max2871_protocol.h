@@ -0,0 +1,182 @@
+/* max2871_protocol.h
+   (Framed binary control protocol for PC-driven tuning)
+
+   Frame layout, both directions:
+
+     +------+-----+-----+-------------------+-------+
+     | 0xA5 | CMD | LEN | PAYLOAD[LEN]      | CRC-8 |
+     +------+-----+-----+-------------------+-------+
+
+   CRC-8 uses polynomial 0x07 over CMD, LEN and PAYLOAD. Multi-byte fields
+   are little-endian. Replies carry the request CMD with bit 7 set and
+   start with a status byte. Frequencies outside 23500-6000000 kHz and
+   DIVA above 7 get BAD_VALUE; a list stops there, 'count' says how far
+   it got.
+
+     CMD   Request payload                  Reply payload
+     0x01  TUNE       freqKHz u32           status
+     0x02  TUNE_LIST  freqKHz u32 x n       status, count u8
+     0x03  TUNE_FMN   (fmn u32, diva u8) x n status, count u8
+     0x04  REG_WRITE  word u32 x n          status, count u8
+     0x05  STATUS     -                     status, locked u8, fmn u32, diva u8
+     0x06  STREAM     whole stream records      status, points u16
+
+   The parser assembles one frame at a time in a fixed buffer and hands out
+   a view into that buffer, so no payload is ever copied. The encoder writes
+   straight into a caller-supplied buffer. STREAM payloads are records of
+   the delta register stream in max2871_stream.h.
+
+   (c) 2025 Mark Stanley, GPL-3.0-or-later
+ */
+
+#ifndef MAX2871_PROTOCOL_H
+#define MAX2871_PROTOCOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef MAX2871_PROTO_MAX_PAYLOAD
+#define MAX2871_PROTO_MAX_PAYLOAD 64    // 16 list points per frame
+#endif
+
+class MAX2871;
+class I_MAX2871Transport;
+
+namespace max2871proto {
+
+static constexpr uint8_t SOF = 0xA5;
+static constexpr uint8_t REPLY = 0x80;
+static constexpr uint8_t OVERHEAD = 4;          // SOF, CMD, LEN, CRC
+static constexpr uint16_t MAX_FRAME = MAX2871_PROTO_MAX_PAYLOAD + OVERHEAD;
+
+enum Command : uint8_t {
+    CMD_TUNE      = 0x01,
+    CMD_TUNE_LIST = 0x02,
+    CMD_TUNE_FMN  = 0x03,
+    CMD_REG_WRITE = 0x04,
+    CMD_STATUS    = 0x05,
+    CMD_STREAM    = 0x06
+};
+
+enum Status : uint8_t {
+    STATUS_OK          = 0,
+    STATUS_BAD_LENGTH  = 1,
+    STATUS_BAD_COMMAND = 2,
+    STATUS_BAD_VALUE   = 3
+};
+
+// A received frame. 'payload' points into the parser's buffer and stays
+// valid until the next byte is fed.
+struct Frame {
+    uint8_t cmd;
+    uint8_t len;
+    const uint8_t* payload;
+};
+
+uint8_t crc8(uint8_t crc, const uint8_t* data, size_t len);
+
+inline uint32_t getU32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+inline void putU32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+// Encode a frame into 'out'. Returns the frame size, or 0 if it does not fit.
+size_t encode(uint8_t* out, size_t cap, uint8_t cmd, const uint8_t* payload, uint8_t len);
+
+// Byte-at-a-time frame parser
+class Parser {
+public:
+    enum Result { NEED_MORE, FRAME_READY, FRAME_ERROR };
+
+    Parser() { reset(); }
+
+    void reset() { _state = WAIT_SOF; _count = 0; }
+    Result feed(uint8_t byte);
+    const Frame& frame() const { return _frame; }
+    uint16_t errors() const { return _errors; }
+
+private:
+    enum State { WAIT_SOF, GET_CMD, GET_LEN, GET_PAYLOAD, GET_CRC };
+
+    uint8_t _buf[MAX2871_PROTO_MAX_PAYLOAD];
+    Frame _frame;
+    State _state;
+    uint8_t _count;
+    uint8_t _crc;
+    uint16_t _errors = 0;
+};
+
+// Device side: executes frames against a MAX2871 and encodes the reply
+class Handler {
+public:
+    // Called after each point of a TUNE_LIST / TUNE_FMN batch (e.g. to dwell and sample)
+    typedef void (*PointHook)(uint8_t index, void* ctx);
+
+    explicit Handler(MAX2871& lo) : _lo(lo), _hook(nullptr), _hookCtx(nullptr), _stream(nullptr) {}
+
+    void setPointHook(PointHook hook, void* ctx) { _hook = hook; _hookCtx = ctx; }
+
+    // STREAM writes straight to the transport 'lo' was built with; without one
+    // the command is rejected. The point hook index wraps at 256.
+    void setStreamTransport(I_MAX2871Transport* transport) { _stream = transport; }
+
+    // Returns the reply size written to 'reply' (0 if 'cap' is too small)
+    size_t handle(const Frame& frame, uint8_t* reply, size_t cap);
+
+private:
+    MAX2871& _lo;
+    PointHook _hook;
+    void* _hookCtx;
+    I_MAX2871Transport* _stream;
+
+    void point(uint8_t index) { if (_hook) _hook(index, _hookCtx); }
+    static void streamPoint(uint16_t index, void* ctx) { static_cast<Handler*>(ctx)->point((uint8_t)index); }
+};
+
+// Host side: builds requests and decodes replies over any byte stream
+class Client {
+public:
+    typedef size_t (*WriteFn)(const uint8_t* data, size_t len, void* ctx);
+    typedef int (*ReadFn)(void* ctx);           // next byte, or -1 on timeout
+
+    struct Reply {
+        uint8_t status;
+        uint16_t count;         // points/words executed by batch commands
+        bool locked;            // STATUS only
+        uint32_t fmn;           // STATUS only
+        uint8_t diva;           // STATUS only
+    };
+
+    Client(WriteFn write, ReadFn read, void* ctx) : _write(write), _read(read), _ctx(ctx) {}
+
+    bool tune(double freqMHz, Reply& reply);
+    bool tuneList(const double* freqMHz, uint8_t count, Reply& reply);
+    bool tuneFMN(const uint32_t* fmn, const uint8_t* diva, uint8_t count, Reply& reply);
+    bool writeRegisters(const uint32_t* words, uint8_t count, Reply& reply);
+    bool status(Reply& reply);
+
+    // Sends an encoded stream, split into frames at record boundaries.
+    // 'reply.count' is the total of points played.
+    bool stream(const uint8_t* records, size_t len, Reply& reply);
+
+private:
+    WriteFn _write;
+    ReadFn _read;
+    void* _ctx;
+    Parser _parser;
+
+    bool transact(uint8_t cmd, const uint8_t* payload, uint8_t len, Reply& reply);
+};
+
+// Frequencies travel as whole kHz
+inline uint32_t mhzToKHz(double freqMHz) { return (uint32_t)(freqMHz * 1000.0 + 0.5); }
+
+} // namespace max2871proto
+
+#endif // MAX2871_PROTOCOL_H
@@ -0,0 +1,240 @@
+#include "max2871_stream.h"
+
+namespace max2871stream {
+
+static uint8_t bitCount(uint8_t v) {
+    uint8_t n = 0;
+    for (; v; v &= (uint8_t)(v - 1)) n++;
+    return n;
+}
+
+static uint8_t byteMask(uint32_t x) {
+    uint8_t nib = 0;
+    for (uint8_t b = 0; b < 4; ++b) {
+        if ((x >> (8 * b)) & 0xFF) nib |= (uint8_t)(1 << b);
+    }
+    return nib;
+}
+
+size_t recordLength(const uint8_t* p, size_t avail) {
+    if (avail == 0) return 0;
+    uint8_t tag = p[0];
+    size_t n;
+    if (tag & TAG_RUN) {
+        n = 4;
+    } else if (tag & TAG_ABSOLUTE) {
+        n = 1 + 4 * (size_t)bitCount(tag & 0x3F);
+    } else {
+        uint8_t regs = bitCount(tag & 0x3F);
+        n = 1 + (regs + 1) / 2;
+        if (avail < n) return 0;
+        for (uint8_t i = 0; i < regs; ++i) n += bitCount((p[1 + i / 2] >> (4 * (i & 1))) & 0xF);
+    }
+    return avail >= n ? n : 0;
+}
+
+// ---- Host side ----
+
+// R0 'from' -> 'to' as one RUN step, if the step fits and reproduces 'to' exactly
+static bool runStep(uint32_t from, uint32_t to, uint16_t m, int8_t& dN, uint16_t& dF) {
+    if (m == 0 || ((from ^ to) & ~R0_NF)) return false;
+    int32_t n0 = (from >> 15) & 0xFFFF, f0 = (from >> 3) & 0xFFF;
+    int32_t n1 = (to >> 15) & 0xFFFF, f1 = (to >> 3) & 0xFFF;
+    if (f0 >= m || f1 >= m) return false;
+    int32_t d = (n1 - n0) * (int32_t)m + (f1 - f0);
+    int32_t q = d / m;
+    int32_t r = d % m;
+    if (r < 0) {
+        r += m;
+        q--;
+    }
+    if (q < -128 || q > 127) return false;
+    dN = (int8_t)q;
+    dF = (uint16_t)r;
+    return stepR0(from, m, dN, dF) == to;
+}
+
+void Encoder::reset() {
+    _len = 0;
+    _points = 0;
+    _synced = false;
+    _run = 0;
+    for (uint8_t r = 0; r < 6; ++r) _img[r] = r;
+}
+
+bool Encoder::keyframe(const uint32_t* image) {
+    if (!flushRun()) return false;
+    for (uint8_t r = 0; r < 6; ++r) {
+        if ((image[r] & 0x7) != r) return false;
+    }
+    if (_len + 25 > _cap) return false;
+    _out[_len++] = TAG_ABSOLUTE | 0x3F;
+    for (int r = 5; r >= 0; --r) {
+        for (uint8_t b = 0; b < 4; ++b) _out[_len++] = (uint8_t)(image[r] >> (8 * b));
+        _img[r] = image[r];
+    }
+    _synced = true;
+    _points++;
+    return true;
+}
+
+bool Encoder::point(const uint32_t* words, uint8_t count) {
+    if (!_synced) return false;
+    uint32_t next[6];
+    uint8_t mask = 0;
+    int prev = 6;
+    for (uint8_t r = 0; r < 6; ++r) next[r] = _img[r];
+    for (uint8_t i = 0; i < count; ++i) {
+        int r = words[i] & 0x7;
+        if (r >= prev) return false;                    // R5..R0, each at most once
+        prev = r;
+        mask |= (uint8_t)(1 << r);
+        next[r] = words[i];
+    }
+
+    if (mask == 0x01) {
+        int8_t dN;
+        uint16_t dF;
+        if (runStep(_img[0], next[0], (_img[1] >> 3) & 0xFFF, dN, dF)) {
+            if (_run && (dN != _runN || dF != _runF || _run == MAX_RUN) && !flushRun()) return false;
+            if (!_run) {
+                _runBase = _img[0];
+                _runN = dN;
+                _runF = dF;
+            }
+            _run++;
+            _img[0] = next[0];
+            _points++;
+            return true;
+        }
+    }
+
+    if (!flushRun()) return false;
+    uint32_t xors[6];
+    for (uint8_t r = 0; r < 6; ++r) xors[r] = next[r] ^ _img[r];
+    if (!delta(mask, xors)) return false;
+    for (uint8_t r = 0; r < 6; ++r) _img[r] = next[r];
+    _points++;
+    return true;
+}
+
+bool Encoder::finish() {
+    return flushRun();
+}
+
+bool Encoder::flushRun() {
+    if (_run == 0) return true;
+    if (_run == 1) {
+        // A lone step is often shorter as a DELTA
+        uint32_t xors[6] = {0, 0, 0, 0, 0, 0};
+        xors[0] = _img[0] ^ _runBase;
+        if (bitCount(byteMask(xors[0])) <= 2) {
+            if (!delta(0x01, xors)) return false;
+            _run = 0;
+            return true;
+        }
+    }
+    if (_len + 4 > _cap) return false;
+    _out[_len++] = (uint8_t)(TAG_RUN | (_run - 1));
+    _out[_len++] = (uint8_t)_runN;
+    _out[_len++] = (uint8_t)_runF;
+    _out[_len++] = (uint8_t)(_runF >> 8);
+    _run = 0;
+    return true;
+}
+
+bool Encoder::delta(uint8_t mask, const uint32_t* xors) {
+    uint8_t nibbles[6];
+    uint8_t k = 0;
+    size_t n = 1;
+    for (int r = 5; r >= 0; --r) {
+        if (!(mask & (1 << r))) continue;
+        nibbles[k] = byteMask(xors[r]);
+        n += bitCount(nibbles[k]);
+        k++;
+    }
+    n += (k + 1) / 2;
+    if (_len + n > _cap) return false;
+
+    _out[_len++] = TAG_DELTA | mask;
+    for (uint8_t i = 0; i < k; i += 2) {
+        _out[_len++] = (uint8_t)(nibbles[i] | (i + 1 < k ? nibbles[i + 1] << 4 : 0));
+    }
+    k = 0;
+    for (int r = 5; r >= 0; --r) {
+        if (!(mask & (1 << r))) continue;
+        for (uint8_t b = 0; b < 4; ++b) {
+            if (nibbles[k] & (1 << b)) _out[_len++] = (uint8_t)(xors[r] >> (8 * b));
+        }
+        k++;
+    }
+    return true;
+}
+
+// ---- Device side ----
+
+void Decoder::begin(const uint32_t* image) {
+    for (uint8_t r = 0; r < 6; ++r) _img[r] = image[r];
+    _index = 0;
+}
+
+void Decoder::play(const uint32_t* words, uint8_t count) {
+    if (count) _out.spiWriteRegisters(words, count);
+    if (_hook) _hook(_index, _hookCtx);
+    _index++;
+}
+
+int32_t Decoder::feed(const uint8_t* data, size_t len) {
+    int32_t played = 0;
+    size_t pos = 0;
+    while (pos < len) {
+        const uint8_t* p = data + pos;
+        size_t n = recordLength(p, len - pos);
+        if (n == 0) return -1;
+        pos += n;
+        uint8_t tag = p[0];
+
+        if (tag & TAG_RUN) {
+            uint16_t m = (_img[1] >> 3) & 0xFFF;
+            int8_t dN = (int8_t)p[1];
+            uint16_t dF = (uint16_t)(p[2] | (p[3] << 8));
+            if (dF >= m) return -1;
+            for (uint8_t c = 0; c <= (tag & 0x7F); ++c) {
+                _img[0] = stepR0(_img[0], m, dN, dF);
+                play(&_img[0], 1);
+                played++;
+            }
+            continue;
+        }
+
+        // Build the point's words first; the image only changes once they are valid
+        uint32_t words[6];
+        uint8_t k = 0;
+        uint8_t mask = tag & 0x3F;
+        const uint8_t* q = p + 1;
+        if (!(tag & TAG_ABSOLUTE)) q += (bitCount(mask) + 1) / 2;
+        for (int r = 5; r >= 0; --r) {
+            if (!(mask & (1 << r))) continue;
+            uint32_t w;
+            if (tag & TAG_ABSOLUTE) {
+                w = (uint32_t)q[0] | ((uint32_t)q[1] << 8) | ((uint32_t)q[2] << 16) | ((uint32_t)q[3] << 24);
+                q += 4;
+            } else {
+                uint8_t nib = (p[1 + k / 2] >> (4 * (k & 1))) & 0xF;
+                uint32_t x = 0;
+                for (uint8_t b = 0; b < 4; ++b) {
+                    if (nib & (1 << b)) x |= (uint32_t)(*q++) << (8 * b);
+                }
+                w = _img[r] ^ x;
+            }
+            if ((w & 0x7) != (uint32_t)r) return -1;
+            words[k++] = w;
+        }
+        for (uint8_t i = 0; i < k; ++i) _img[words[i] & 0x7] = words[i];
+        play(words, k);
+        played++;
+    }
+    return played;
+}
+
+} // namespace max2871stream
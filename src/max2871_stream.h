@@ -0,0 +1,132 @@
+/* max2871_stream.h
+   (Delta-encoded register stream for host-planned sweeps)
+
+   The host runs the driver itself, records the words each sweep point
+   writes and encodes them against the previous point. The device only
+   applies the stream: no solver, no float math, one transport batch per
+   point. Records, in the order the points are played:
+
+     Tag          Meaning            Followed by
+     00mm mmmm    DELTA point        nibbles, changed bytes
+     01mm mmmm    ABSOLUTE point     word u32 x popcount(m)
+     1ccc cccc    RUN of c+1 points  dN i8, dF u16
+
+   'm' is the set of registers the point writes (bit r = Rr); they are
+   written R5 first, R0 last, as the driver does. A DELTA carries, per
+   written register, a 4-bit mask of the bytes that differ from the last
+   word sent to that register (two registers per byte, the first in the low
+   nibble), then those XOR bytes, least significant first. A nibble of 0
+   rewrites the same word (e.g. R0 committing a new M). A RUN repeats an
+   R0-only step: F += dF (carrying into N at M), then N += dN, with M taken
+   from R1. Multi-byte fields are little-endian.
+
+   A linear sweep with a fixed M costs 4 bytes per run of up to 128 points;
+   other points cost 1 byte plus the changed bytes. The stream must start
+   with an ABSOLUTE point of all six registers (Encoder::keyframe) so that
+   both sides agree on the base.
+
+   Decoder::feed() works on whole records straight out of the caller's
+   buffer (e.g. a protocol frame); nothing is copied.
+
+   (c) 2025 Mark Stanley, GPL-3.0-or-later
+ */
+
+#ifndef MAX2871_STREAM_H
+#define MAX2871_STREAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "max2871_transport.h"
+
+namespace max2871stream {
+
+static constexpr uint8_t TAG_DELTA    = 0x00;
+static constexpr uint8_t TAG_ABSOLUTE = 0x40;
+static constexpr uint8_t TAG_RUN      = 0x80;
+static constexpr uint8_t MAX_RUN      = 128;
+static constexpr uint32_t R0_NF       = 0x7FFFFFF8;     // R0 N[30:15] and FRAC[14:3]
+
+// Size of the record at 'p', or 0 if it is longer than 'avail'
+size_t recordLength(const uint8_t* p, size_t avail);
+
+// One RUN step of R0, shared by encoder and decoder so both compute the same word
+inline uint32_t stepR0(uint32_t r0, uint16_t m, int8_t dN, uint16_t dF) {
+    uint16_t n = (r0 >> 15) & 0xFFFF;
+    uint16_t f = (r0 >> 3) & 0xFFF;
+    f += dF;
+    if (f >= m) {
+        f -= m;
+        n++;
+    }
+    n += dN;
+    return (r0 & ~R0_NF) | ((uint32_t)n << 15) | ((uint32_t)f << 3);
+}
+
+// Host side: appends records to a caller-supplied buffer
+class Encoder {
+public:
+    Encoder(uint8_t* out, size_t cap) : _out(out), _cap(cap) { reset(); }
+
+    void reset();
+
+    // First point: all six words of 'image' (Reg[0..5]), absolute
+    bool keyframe(const uint32_t* image);
+
+    // Next point: the words the driver wrote for it, in write order
+    bool point(const uint32_t* words, uint8_t count);
+
+    // Flush a pending run. Call once after the last point.
+    bool finish();
+
+    size_t size() const { return _len; }
+    uint32_t points() const { return _points; }
+
+private:
+    uint8_t* _out;
+    size_t _cap;
+    size_t _len;
+    uint32_t _points;
+    bool _synced;
+    uint32_t _img[6];           // last word sent to each register
+    uint8_t _run;               // points in the pending run
+    int8_t _runN;
+    uint16_t _runF;
+    uint32_t _runBase;          // R0 before the pending run
+
+    bool flushRun();
+    bool delta(uint8_t mask, const uint32_t* xors);
+};
+
+// Device side: applies records to the transport, one batch per point
+class Decoder {
+public:
+    typedef void (*PointHook)(uint16_t index, void* ctx);
+
+    explicit Decoder(I_MAX2871Transport& out) : _out(out), _hook(nullptr), _hookCtx(nullptr), _index(0) {}
+
+    // Words the chip holds now (Reg[0..5])
+    void begin(const uint32_t* image);
+
+    // Called after each point's writes (e.g. to dwell and sample)
+    void setPointHook(PointHook hook, void* ctx) { _hook = hook; _hookCtx = ctx; }
+
+    // Apply whole records. Returns points played, or -1 on a truncated or
+    // malformed record (points before it have been played).
+    int32_t feed(const uint8_t* data, size_t len);
+
+    const uint32_t* image() const { return _img; }
+    uint16_t points() const { return _index; }         // played since begin()
+
+private:
+    I_MAX2871Transport& _out;
+    PointHook _hook;
+    void* _hookCtx;
+    uint16_t _index;
+    uint32_t _img[6];
+
+    void play(const uint32_t* words, uint8_t count);
+};
+
+} // namespace max2871stream
+
+#endif // MAX2871_STREAM_H
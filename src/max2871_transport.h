@@ -17,6 +17,18 @@ public:
 
     virtual void spiWriteRegister(uint32_t value) = 0;
     virtual bool readMuxout() = 0;
+
+    // All words of one update, in order. Transports that can queue several
+    // transfers (DMA, Linux spidev) override this; the default writes one by one.
+    virtual void spiWriteRegisters(const uint32_t* values, uint8_t count) {
+        for (uint8_t i = 0; i < count; ++i) spiWriteRegister(values[i]);
+    }
+
+    // Optional register readback. The driver routes MUXOUT to the SPI readback
+    // mux before calling readRegister6() and restores it afterwards. Boards
+    // without a readback path keep the defaults.
+    virtual bool canReadRegisters() const { return false; }
+    virtual uint32_t readRegister6() { return 0; }
 };
 
 #endif // MAX2871_TRANSPORT_H
@@ -0,0 +1,64 @@
+#include "max2871_worker.h"
+
+#if MAX2871_HAS_WORKER
+
+MAX2871SolverWorker::MAX2871SolverWorker(double refMHz)
+    : _shadow(refMHz, *this, *this), _outstanding(0), _held(false), _begun(false) {
+}
+
+MAX2871SolverWorker::MAX2871SolverWorker(double refMHz, const MAX2871::max2871Registers& startupRegisters)
+    : _shadow(refMHz, *this, *this, startupRegisters), _outstanding(0), _held(false), _begun(false) {
+}
+
+bool MAX2871SolverWorker::begin(const MAX2871::max2871Registers& image) {
+    _begun.store(false);
+    _held = false;
+    bool ok = _shadow.adoptImage(image);
+    _begun.store(ok);
+    return ok;
+}
+
+bool MAX2871SolverWorker::request(double freqMHz, uint32_t tag) {
+    Request r;
+    r.freqMHz = freqMHz;
+    r.tag = tag;
+    if (!_requests.push(r)) return false;
+    _outstanding++;
+    return true;
+}
+
+/*  The main core's whole share of a tune: pop the words and write them.
+    No float math here, so the step time is bus time.
+ */
+bool MAX2871SolverWorker::commit(MAX2871& lo, uint32_t* tag) {
+    Result r;
+    if (!_results.pop(r)) return false;
+    lo.writeWords(r.words, r.count);
+    _outstanding--;
+    if (tag) *tag = r.tag;
+    return true;
+}
+
+/*  A result that finds the result queue full is held and offered again on
+    the next call, so the shadow never runs ahead of what will be committed.
+ */
+bool MAX2871SolverWorker::service() {
+    if (!_begun.load()) return false;
+    if (!_held) {
+        Request r;
+        if (!_requests.pop(r)) return false;
+        _solved.tag = r.tag;
+        _solved.count = 0;
+        _shadow.setFrequency(r.freqMHz);
+        _held = true;
+    }
+    if (!_results.push(_solved)) return true;
+    _held = false;
+    return true;
+}
+
+void MAX2871SolverWorker::spiWriteRegister(uint32_t value) {
+    if (_solved.count < 6) _solved.words[_solved.count++] = value;
+}
+
+#endif // MAX2871_HAS_WORKER
@@ -0,0 +1,135 @@
+/* max2871_worker.h
+   (Solver on one core, SPI commits on the other)
+
+   setFrequency() runs the float solver and the SPI writes back to back, so
+   a sweep step costs solve time plus bus time. On a dual-core part (RP2040)
+   the solver can run on the second core instead:
+
+     MAX2871SolverWorker worker(66.0);
+     worker.begin(lo.Curr);                  // what the chip holds now
+
+     void loop1() { worker.service(); }      // core 1: solve queued requests
+
+     worker.request(f);                      // core 0: queue the next point...
+     worker.commit(lo);                      // ...and write whichever result is ready
+
+   The worker keeps its own shadow driver and assumes every result is
+   committed, in order, to the chip 'lo' drives. Each result is therefore the
+   exact words lo.setFrequency() would have written, write rules and octave
+   path included. Other changes to 'lo' (outputs, standby) must wait until
+   outstanding() is 0 and be followed by begin(lo.Curr). Until begin() has
+   been given a valid image, service() leaves requests queued.
+
+   The two queues are single-producer/single-consumer rings on std::atomic
+   loads and stores, with no read-modify-write. They are lock-free on a
+   Cortex-M0+, which has no exclusive-access instructions, and on the host,
+   where the worker runs as a second thread for tests and benchmarks. AVR
+   has neither <atomic> nor a second core, so there this header declares
+   nothing.
+
+   (c) 2025 Mark Stanley, GPL-3.0-or-later
+ */
+
+#ifndef MAX2871_WORKER_H
+#define MAX2871_WORKER_H
+
+#ifndef MAX2871_HAS_WORKER
+  #if defined(__AVR__)
+    #define MAX2871_HAS_WORKER 0
+  #else
+    #define MAX2871_HAS_WORKER 1
+  #endif
+#endif
+
+#if MAX2871_HAS_WORKER
+
+#include <stdint.h>
+#include <atomic>
+#include "max2871.h"
+
+#ifndef MAX2871_WORKER_QUEUE
+#define MAX2871_WORKER_QUEUE 8       // entries per direction, power of two
+#endif
+
+// One producer thread/core, one consumer thread/core. One slot stays empty.
+template<typename T, uint8_t SIZE>
+class SpscFifo {
+    static_assert(SIZE >= 2 && (SIZE & (SIZE - 1)) == 0, "SpscFifo SIZE must be a power of two");
+
+public:
+    SpscFifo() : _head(0), _tail(0) {}
+
+    bool push(const T& item) {
+        uint8_t head = _head.load(std::memory_order_relaxed);
+        uint8_t next = (uint8_t)((head + 1) & (SIZE - 1));
+        if (next == _tail.load(std::memory_order_acquire)) return false;    // full
+        _slots[head] = item;
+        _head.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item) {
+        uint8_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) return false;    // empty
+        item = _slots[tail];
+        _tail.store((uint8_t)((tail + 1) & (SIZE - 1)), std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+    }
+
+    static constexpr uint8_t capacity() { return SIZE - 1; }
+
+private:
+    T _slots[SIZE];
+    std::atomic<uint8_t> _head;     // written by the producer only
+    std::atomic<uint8_t> _tail;     // written by the consumer only
+};
+
+class MAX2871SolverWorker : public I_MAX2871Transport, public IDelayProvider {
+public:
+    struct Request {
+        double freqMHz;
+        uint32_t tag;
+    };
+
+    struct Result {
+        uint32_t tag;
+        uint8_t count;
+        uint32_t words[6];              // R5 first, R0 last, as the driver writes them
+    };
+
+    explicit MAX2871SolverWorker(double refMHz);
+    MAX2871SolverWorker(double refMHz, const MAX2871::max2871Registers& startupRegisters);
+
+    // Start from the image the chip holds. Only with nothing outstanding.
+    bool begin(const MAX2871::max2871Registers& image);
+
+    // ---- Main core ----
+    bool request(double freqMHz, uint32_t tag = 0);      // false when the queue is full
+    bool commit(MAX2871& lo, uint32_t* tag = nullptr);   // write one ready result, false if none
+    bool ready() const { return !_results.empty(); }
+    uint16_t outstanding() const { return _outstanding; }   // requested, not yet committed
+
+    // ---- Worker core ----
+    bool service();                                     // solve one request, false if none
+
+    // Capture side of the shadow driver
+    void spiWriteRegister(uint32_t value) override;
+    bool readMuxout() override { return true; }
+    void delayMs(uint32_t) override {}
+
+private:
+    MAX2871 _shadow;
+    SpscFifo<Request, MAX2871_WORKER_QUEUE> _requests;
+    SpscFifo<Result, MAX2871_WORKER_QUEUE> _results;
+    uint16_t _outstanding;              // main core only
+    Result _solved;                     // worker core only
+    bool _held;                         // _solved is waiting for room in _results
+    std::atomic<bool> _begun;
+};
+
+#endif // MAX2871_HAS_WORKER
+#endif // MAX2871_WORKER_H
@@ -16,6 +16,9 @@ public:
     static constexpr uint8_t MAX_WRITES = 7;
     uint32_t regWrites[MAX_WRITES];
     uint8_t writeCount = 0;
+    bool locked = false;            // level returned on MUXOUT
+    bool readback = false;          // pretend the board can read R6
+    uint32_t reg6 = 0x00000006;
 
     void delayMs(uint32_t ms) override {
         // delay(ms);
@@ -36,7 +39,9 @@ public:
     }
 
     void setCEPin(bool) {}
-    bool readMuxout() override { return false; }
+    bool readMuxout() override { return locked; }
+    bool canReadRegisters() const override { return readback; }
+    uint32_t readRegister6() override { return reg6; }
 };
 
 #endif // MOCK_HAL_H
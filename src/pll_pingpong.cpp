@@ -0,0 +1,69 @@
+#include "pll_pingpong.h"
+
+void PLLPingPong::resetStats() {
+    _stats.steps = 0;
+    _stats.stalls = 0;
+    _stats.stallUs = 0;
+    _stats.maxStallUs = 0;
+}
+
+// Point after 'index', NONE at the end of a single pass
+uint16_t PLLPingPong::after(uint16_t index) const {
+    if (index == NONE) return 0;
+    if (index + 1 < _count) return index + 1;
+    return _repeat ? 0 : NONE;
+}
+
+void PLLPingPong::tune(uint8_t chip, uint16_t index) {
+    if (index == NONE || _tuned[chip] == index) return;
+    _chip[chip]->setFrequency(_points[index]);
+    _tuned[chip] = index;
+}
+
+void PLLPingPong::start(const double* points, uint16_t count, uint32_t nowUs, uint32_t dwellUs,
+                        bool repeat) {
+    _points = points;
+    _count = count;
+    _repeat = repeat;
+    _dwellUs = dwellUs;
+    _running = count > 0 && count != NONE;
+    if (!_running) return;
+    _tuned[0] = _tuned[1] = NONE;
+    _current = NONE;
+    _waiting = false;
+    _active = 1;                                        // chip 0 holds the first point to show
+    _dueUs = nowUs;
+    tune(0, 0);
+    tune(1, after(0));
+}
+
+bool PLLPingPong::tick(uint32_t nowUs) {
+    if (!_running) return false;
+    if ((int32_t)(nowUs - _dueUs) < 0) return false;    // still dwelling
+
+    uint16_t next = after(_current);
+    if (next == NONE) {                                 // last point has had its dwell
+        _running = false;
+        return false;
+    }
+    uint8_t idle = _active ^ 1;
+    if (!_chip[idle]->isLocked()) {
+        if (_current != NONE) _waiting = true;          // the first lock is not a stall
+        return false;
+    }
+
+    if (_waiting) {
+        uint32_t stall = nowUs - _dueUs;
+        _stats.stalls++;
+        _stats.stallUs += stall;
+        if (stall > _stats.maxStallUs) _stats.maxStallUs = stall;
+        _waiting = false;
+    }
+    if (_output) _output(idle, _ctx);
+    _active = idle;
+    _current = next;
+    _dueUs = nowUs + _dwellUs;
+    _stats.steps++;
+    tune(_active ^ 1, after(next));                     // the chip just switched out
+    return true;
+}
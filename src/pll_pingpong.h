@@ -0,0 +1,90 @@
+/* pll_pingpong.h
+   (Two synthesizers taking turns on one output: lock time behind dwell)
+
+   With one chip every step costs the PLL lock time, because the chip that
+   retunes is also the one on the output. With two chips and an RF switch
+   the next point is tuned on the idle chip while the other one is being
+   measured, and the switch flips once that chip reports lock:
+
+     static void route(uint8_t chip, void*) { digitalWrite(RF_SW, chip ? HIGH : LOW); }
+
+     PLLPingPong pair(loA, loB, route);
+     pair.start(points, n, micros(), 500);      // at least 500 us per point
+     while (pair.running()) {
+         if (pair.tick(micros())) measure(pair.point());
+     }
+
+   A point stays on the output for at least 'dwellUs'. When its dwell is
+   over the switch flips as soon as the idle chip's isLocked() is true,
+   and the chip just switched out is tuned to the point after it. If
+   lock takes longer than the dwell the flip waits, and the wait is counted
+   as a stall, so a step costs max(dwell, tune + lock) instead of
+   dwell + tune + lock.
+
+   Works with any I_PLLSynthesizer; the chips may sit on one bus. Times are
+   in microseconds, modulo 2^32.
+
+   (c) 2025 Mark Stanley, GPL-3.0-or-later
+ */
+
+#ifndef PLL_PINGPONG_H
+#define PLL_PINGPONG_H
+
+#include <stdint.h>
+#include "I_PLLSynthesizer.h"
+
+class PLLPingPong {
+public:
+    // Route chip 0 (the first synthesizer) or chip 1 to the output
+    typedef void (*OutputFn)(uint8_t chip, void* ctx);
+
+    struct Stats {
+        uint32_t steps;                 // points put on the output
+        uint32_t stalls;                // dwell over, idle chip not locked yet
+        uint32_t stallUs;               // total time spent waiting for lock
+        uint32_t maxStallUs;
+    };
+
+    static constexpr uint16_t NONE = 0xFFFF;
+
+    PLLPingPong(I_PLLSynthesizer& a, I_PLLSynthesizer& b, OutputFn output, void* ctx = nullptr)
+        : _chip{&a, &b}, _output(output), _ctx(ctx), _points(nullptr), _count(0),
+          _repeat(false), _running(false), _waiting(false), _active(0), _current(NONE),
+          _dwellUs(0), _dueUs(0) { _tuned[0] = _tuned[1] = NONE; resetStats(); }
+
+    // Tunes both chips to the first two points. The first point goes out
+    // once chip 0 is locked. 'points' must stay valid while running.
+    void start(const double* points, uint16_t count, uint32_t nowUs, uint32_t dwellUs,
+               bool repeat = false);
+    void stop() { _running = false; }
+
+    // Call from a polling loop or timer. True when the output flipped.
+    bool tick(uint32_t nowUs);
+
+    bool running() const { return _running; }
+    uint16_t point() const { return _current; }        // on the output, NONE before the first
+    uint8_t activeChip() const { return _active; }
+    const Stats& stats() const { return _stats; }
+    void resetStats();
+
+private:
+    I_PLLSynthesizer* _chip[2];
+    OutputFn _output;
+    void* _ctx;
+    const double* _points;
+    uint16_t _count;
+    uint16_t _tuned[2];                 // point each chip was last tuned to
+    bool _repeat;
+    bool _running;
+    bool _waiting;                      // dwell over, counting a stall
+    uint8_t _active;
+    uint16_t _current;
+    uint32_t _dwellUs;
+    uint32_t _dueUs;                    // end of the current point's dwell
+    Stats _stats;
+
+    uint16_t after(uint16_t index) const;
+    void tune(uint8_t chip, uint16_t index);
+};
+
+#endif // PLL_PINGPONG_H
@@ -0,0 +1,68 @@
+#include "spi_bus.h"
+
+uint8_t SpiBusManager::addDevice(const SpiDeviceConfig& config) {
+    if (_devices >= SPI_BUS_MAX_DEVICES) return NO_DEVICE;
+    _config[_devices] = config;
+    _port.setupSelect(config.selectPin, config.select == SPI_SELECT_ACTIVE_LOW);
+    return _devices++;
+}
+
+bool SpiBusManager::submit(uint8_t device, const uint8_t* tx, uint8_t len, uint8_t* rx) {
+    if (device >= _devices || len == 0 || len > SPI_BUS_MAX_BYTES) return false;
+    if (_queued == SPI_BUS_QUEUE) flush();
+    Transaction& t = _queue[_queued++];
+    t.device = device;
+    t.len = len;
+    for (uint8_t i = 0; i < len; ++i) t.tx[i] = tx[i];
+    t.rx = rx;
+    return true;
+}
+
+/*  Priority order without reordering any one device: repeatedly take the
+    oldest transaction of the highest priority still queued. The queue is a
+    handful of entries, so the selection scan costs less than keeping it sorted.
+ */
+uint8_t SpiBusManager::flush() {
+    uint8_t ran = 0;
+    bool done[SPI_BUS_QUEUE] = {false};
+    bool open = false;
+    uint32_t clockHz = 0;
+    uint8_t mode = 0;
+
+    while (ran < _queued) {
+        int8_t next = -1;
+        for (uint8_t i = 0; i < _queued; ++i) {
+            if (done[i]) continue;
+            if (next < 0 || _config[_queue[i].device].priority > _config[_queue[next].device].priority) next = i;
+        }
+        const Transaction& t = _queue[next];
+        const SpiDeviceConfig& c = _config[t.device];
+        if (!open || c.clockHz != clockHz || c.mode != mode) {
+            if (open) _port.endSession();
+            _port.beginSession(c.clockHz, c.mode);
+            _sessions++;
+            open = true;
+            clockHz = c.clockHz;
+            mode = c.mode;
+        }
+        run(t);
+        done[next] = true;
+        ran++;
+    }
+    if (open) _port.endSession();
+    _queued = 0;
+    return ran;
+}
+
+void SpiBusManager::run(const Transaction& t) {
+    const SpiDeviceConfig& c = _config[t.device];
+    if (c.select == SPI_SELECT_ACTIVE_LOW) {
+        _port.writePin(c.selectPin, false);
+        _port.transfer(t.tx, t.rx, t.len);
+        _port.writePin(c.selectPin, true);
+    } else {
+        _port.transfer(t.tx, t.rx, t.len);
+        _port.writePin(c.selectPin, true);                  // latch
+        _port.writePin(c.selectPin, false);
+    }
+}
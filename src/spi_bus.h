@@ -0,0 +1,144 @@
+/* spi_bus.h
+   (One SPI bus shared by the LOs, the attenuator and the ADC)
+
+   On the SpecAnn RF board, SEL_LO1/2/3, SEL_ATTEN and the ADC select all hang
+   off the same MOSI/MISO/SCK. Rather than each driver owning SPI, they hand
+   transactions to an SpiBusManager:
+
+   - every device is registered once with its clock, SPI mode, select pin,
+     select style and priority, and each transaction runs with exactly those
+   - queued transactions go out highest priority first; a device's own
+     transactions keep their order
+   - back-to-back transactions with the same clock and mode share one bus
+     session (one beginTransaction/endTransaction) and only toggle selects
+
+   The physical bus sits behind I_SpiPort, so the manager runs unchanged on
+   an Arduino (ArduinoSpiPort) or against a recording port in host tests.
+
+     ArduinoSpiPort port;
+     SpiBusManager bus(port);
+     uint8_t lo1 = bus.addDevice({20000000UL, 0, A3, SPI_SELECT_LATCH, 2});
+     uint8_t att = bus.addDevice({10000000UL, 0, A5, SPI_SELECT_LATCH, 1});
+     SpiBusTransport lo1Bus(bus, lo1, PLL_MUX);
+     MAX2871 lo(66.0, lo1Bus, timing);
+
+   (c) 2025 Mark Stanley, GPL-3.0-or-later
+ */
+
+#ifndef SPI_BUS_H
+#define SPI_BUS_H
+
+#include <stdint.h>
+#include "max2871_transport.h"
+
+#ifndef SPI_BUS_MAX_DEVICES
+#define SPI_BUS_MAX_DEVICES 6
+#endif
+#ifndef SPI_BUS_QUEUE
+#define SPI_BUS_QUEUE 16           // enough for a full 6-word update of two LOs
+#endif
+#ifndef SPI_BUS_MAX_BYTES
+#define SPI_BUS_MAX_BYTES 4        // one MAX2871 word
+#endif
+
+// Physical bus: sessions, byte transfers and the select/GPIO lines
+class I_SpiPort {
+public:
+    virtual ~I_SpiPort() {}
+
+    virtual void beginSession(uint32_t clockHz, uint8_t mode) = 0;
+    virtual void transfer(const uint8_t* tx, uint8_t* rx, uint8_t len) = 0;
+    virtual void endSession() = 0;
+    virtual void writePin(uint8_t pin, bool high) = 0;
+    virtual bool readPin(uint8_t pin) = 0;
+
+    // Called once per device: make 'pin' an output at its idle level
+    virtual void setupSelect(uint8_t pin, bool idleHigh) { writePin(pin, idleHigh); }
+};
+
+enum SpiSelect : uint8_t {
+    SPI_SELECT_ACTIVE_LOW = 0,      // CS low for the transfer (ADCs)
+    SPI_SELECT_LATCH      = 1       // idle low, pulsed high after the data (MAX2871 LE, PE43xx)
+};
+
+struct SpiDeviceConfig {
+    uint32_t clockHz;
+    uint8_t mode;                   // SPI mode 0..3
+    uint8_t selectPin;
+    uint8_t select;                 // SpiSelect
+    uint8_t priority;               // higher goes first
+};
+
+class SpiBusManager {
+public:
+    static constexpr uint8_t NO_DEVICE = 0xFF;
+
+    explicit SpiBusManager(I_SpiPort& port) : _port(port), _devices(0), _queued(0), _sessions(0) {}
+
+    // Returns the device id, or NO_DEVICE when the table is full
+    uint8_t addDevice(const SpiDeviceConfig& config);
+
+    // Queue 'len' bytes for 'device'. 'rx', if given, is filled when the
+    // transaction runs. A full queue is flushed first. False on bad arguments.
+    bool submit(uint8_t device, const uint8_t* tx, uint8_t len, uint8_t* rx = nullptr);
+
+    // Run everything queued. Returns the number of transactions run.
+    uint8_t flush();
+
+    uint8_t queued() const { return _queued; }
+    uint32_t sessions() const { return _sessions; }     // bus sessions opened so far
+    bool readPin(uint8_t pin) { return _port.readPin(pin); }
+
+private:
+    struct Transaction {
+        uint8_t device;
+        uint8_t len;
+        uint8_t tx[SPI_BUS_MAX_BYTES];
+        uint8_t* rx;
+    };
+
+    I_SpiPort& _port;
+    SpiDeviceConfig _config[SPI_BUS_MAX_DEVICES];
+    Transaction _queue[SPI_BUS_QUEUE];
+    uint8_t _devices;
+    uint8_t _queued;
+    uint32_t _sessions;
+
+    void run(const Transaction& t);
+};
+
+// MAX2871 transport over a shared bus: one transaction per word, flushed per update.
+// A word the manager refuses (e.g. 'device' was never registered) is counted
+// in errors(), since the transport interface has no return value.
+class SpiBusTransport : public I_MAX2871Transport {
+public:
+    SpiBusTransport(SpiBusManager& bus, uint8_t device, uint8_t muxPin = 0xFF)
+        : _bus(bus), _device(device), _mux(muxPin), _errors(0) {}
+
+    void spiWriteRegister(uint32_t value) override {
+        spiWriteRegisters(&value, 1);
+    }
+
+    void spiWriteRegisters(const uint32_t* values, uint8_t count) override {
+        for (uint8_t i = 0; i < count; ++i) {
+            uint8_t tx[4] = {(uint8_t)(values[i] >> 24), (uint8_t)(values[i] >> 16),
+                             (uint8_t)(values[i] >> 8), (uint8_t)values[i]};     // MSB first
+            if (!_bus.submit(_device, tx, 4)) _errors++;
+        }
+        _bus.flush();
+    }
+
+    bool readMuxout() override {
+        return _mux != 0xFF && _bus.readPin(_mux);
+    }
+
+    uint32_t errors() const { return _errors; }     // words not queued
+
+private:
+    SpiBusManager& _bus;
+    uint8_t _device;
+    uint8_t _mux;
+    uint32_t _errors;
+};
+
+#endif // SPI_BUS_H
@@ -4,7 +4,10 @@
 #include "max2871.h"
 #include <unity.h>
 #include "mock_hal.h"
+#include "max2871_image.h"
 #include <stdio.h>
+#include <string.h>
+#include <new>
 
 // Shared test object
 MockHAL hal;
@@ -71,6 +74,73 @@ void test_param_round_trip(void) {
     }
 }
 
+// --- Coarse full-range sweep (make sweep does the fine-grained one) ---
+#ifdef ARDUINO
+static const double sweep_step = 97.0;   // keep the on-target run short
+#else
+static const double sweep_step = 1.0;
+#endif
+
+// Every point solves to dividers the chip takes, landing within tolerance
+// by the datasheet formula; an unreachable point is flagged, not wrapped
+void test_sweep_flags_unreachable_points(void) {
+    MAX2871::fmnSolution sol;
+    for (double freq = 23.5; freq <= 6000.0; freq += sweep_step) {
+        MAX2871::solveFMN(66.0, freq, sol);
+        TEST_ASSERT_TRUE(MAX2871::validSolution(sol));
+        double out = 66.0 * (sol.N + (double)sol.Frac / sol.M) / (1 << sol.DIVA);
+        TEST_ASSERT_FLOAT_WITHIN(tolerance, freq, out);
+    }
+
+    MAX2871::solveFMN(10.0, 5000.0f, sol);                  // VCO / ref = 500: N wraps
+    TEST_ASSERT_FALSE(MAX2871::validSolution(sol));
+    MAX2871::fmnSolution bad = {100, 100, 50, 0};           // Frac = M
+    TEST_ASSERT_FALSE(MAX2871::validSolution(bad));
+    bad = {10, 4096, 50, 0};
+    TEST_ASSERT_FALSE(MAX2871::validSolution(bad));
+    bad = {10, 100, 18, 0};                                 // fractional N below 19
+    TEST_ASSERT_FALSE(MAX2871::validSolution(bad));
+    bad = {0, 100, 16, 0};                                  // integer-N goes down to 16
+    TEST_ASSERT_TRUE(MAX2871::validSolution(bad));
+}
+
+// --- Compile-time images match the run-time solver ---
+MAX2871_STATIC_IMAGE(image_1420, 66.0, 1420.0, RF_ALL, +5);
+MAX2871_STATIC_IMAGE(image_5800, 66.0, 5800.0, RF_ALL, +5);
+MAX2871_STATIC_IMAGE(image_23_5, 66.0, 23.5, RF_ALL, +5);
+MAX2871_STATIC_IMAGE(image_A_only, 66.0, 915.0, RF_A, -1);
+MAX2871_STATIC_IMAGE(image_int_n, 66.0, 2970.0, RF_ALL, +5);
+static constexpr MAX2871::max2871Registers image_default = max2871image::build(66.0, 60.0);
+
+// N is 8 bits: VCO / reference must stay under 256
+static_assert(max2871image::validN(66.0, 6000.0), "N = 90");
+static_assert(max2871image::validN(23.6, 6000.0), "N = 254");
+static_assert(!max2871image::validN(23.4, 6000.0), "N = 256");
+static_assert(!max2871image::validN(10.0, 5000.0), "N = 500");
+static_assert(max2871image::validN(15.0, 1500.0), "VCO 3000 MHz, N = 200");
+static_assert(!max2871image::validN(66.0, 0.0), "frequency out of range");
+
+void test_static_image_matches_setFrequency(void) {
+    const MAX2871::max2871Registers* images[] = {&image_1420, &image_5800, &image_23_5, &image_int_n};
+    const double freqs[] = {1420.0, 5800.0, 23.5, 2970.0};
+    for (int i = 0; i < 4; i++) {
+        MockHAL h;
+        MAX2871 synth(66.0, h, h);
+        synth.begin();
+        synth.setFrequency(freqs[i]);
+        TEST_ASSERT_EQUAL_HEX32_ARRAY(synth.Curr.Reg, images[i]->Reg, 6);
+    }
+    TEST_ASSERT_EQUAL_HEX32_ARRAY(MAX2871::defaultRegisters.Reg, image_default.Reg, 6);
+}
+
+void test_static_image_output_fields(void) {
+    uint32_t r4 = image_A_only.Reg[4];
+    TEST_ASSERT_EQUAL_UINT32(1, (r4 >> 5) & 1);     // RFA_EN
+    TEST_ASSERT_EQUAL_UINT32(0, (r4 >> 8) & 1);     // RFB_EN
+    TEST_ASSERT_EQUAL_UINT32(1, (r4 >> 3) & 3);     // APWR = -1 dBm
+    TEST_ASSERT_EQUAL_UINT32(2, (r4 >> 20) & 7);    // 915 MHz -> DIVA 2 (div-by-4)
+}
+
 // Interface Test
 void test_interface_begin_and_setFrequency(void) {
     MockHAL hal;
@@ -102,6 +172,304 @@ void test_outputSelect_marks_R4_only_and_sets_expected_bits(void) {
     }
 }
 
+// --- Hop mode and standby ---
+void test_mute_until_lock_costs_no_extra_writes_per_hop(void) {
+    MockHAL h;
+    MAX2871 synth(66.0, h, h);
+    synth.begin();
+    synth.setFrequency(2400.0);
+    h.writeCount = 0;
+    synth.setMuteUntilLock(true);
+    TEST_ASSERT_EQUAL(2, h.writeCount);                         // R4, R3 once
+    TEST_ASSERT_EQUAL_UINT32(1, (synth.Curr.Reg[4] >> 10) & 1); // MTLD
+    TEST_ASSERT_EQUAL_UINT32(1, (synth.Curr.Reg[3] >> 17) & 1); // MUTEDEL
+
+    h.writeCount = 0;
+    synth.setFrequency(2410.0);                                 // same DIVA: R1 and R0
+    TEST_ASSERT_EQUAL(2, h.writeCount);
+    TEST_ASSERT_EQUAL_UINT32(0x120, synth.Curr.Reg[4] & 0x120); // outputs left enabled
+}
+
+void test_standby_and_wake_keep_shadow(void) {
+    MockHAL h;
+    MAX2871 synth(66.0, h, h);
+    synth.begin();
+    synth.setFrequency(1420.0);
+    MAX2871::max2871Registers before = synth.Curr;
+
+    h.writeCount = 0;
+    synth.standby();
+    TEST_ASSERT_TRUE(synth.isStandby());
+    TEST_ASSERT_EQUAL(1, h.writeCount);
+    TEST_ASSERT_EQUAL_HEX32(before.Reg[2] | (1UL << 5), h.regWrites[0]);
+
+    h.writeCount = 0;
+    synth.wake();
+    TEST_ASSERT_FALSE(synth.isStandby());
+    TEST_ASSERT_EQUAL(2, h.writeCount);
+    TEST_ASSERT_EQUAL_HEX32(before.Reg[2], h.regWrites[0]);
+    TEST_ASSERT_EQUAL_HEX32(before.Reg[0], h.regWrites[1]);
+    TEST_ASSERT_EQUAL_HEX32_ARRAY(before.Reg, synth.Curr.Reg, 6);
+
+    h.writeCount = 0;
+    synth.wake();                                               // already awake
+    TEST_ASSERT_EQUAL(0, h.writeCount);
+}
+
+// --- Integer-N mode ---
+void test_integer_n_mode_follows_frac(void) {
+    MockHAL h;
+    MAX2871 synth(66.0, h, h);
+    synth.begin();
+    synth.setFrequency(2400.0);                                 // fractional
+    uint32_t r1Frac = synth.Curr.Reg[1] & 0x60000000;
+    uint32_t r2Frac = synth.Curr.Reg[2] & 0x180;
+    TEST_ASSERT_EQUAL_UINT32(0, synth.Curr.Reg[0] >> 31);
+
+    h.writeCount = 0;
+    synth.setFrequency(2970.0);                                 // 90 x 33 MHz: integer-N
+    TEST_ASSERT_EQUAL_UINT32(0, synth.Frac);
+    TEST_ASSERT_EQUAL_UINT32(1, synth.Curr.Reg[0] >> 31);       // INT
+    TEST_ASSERT_EQUAL_UINT32(0, (synth.Curr.Reg[1] >> 29) & 3); // CPL off
+    TEST_ASSERT_EQUAL_UINT32(3, (synth.Curr.Reg[2] >> 7) & 3);  // LDF, LDP
+    TEST_ASSERT_EQUAL_HEX32(synth.Curr.Reg[2], h.regWrites[0]); // R2, R1, R0 (same DIVA)
+    TEST_ASSERT_EQUAL_HEX32(synth.Curr.Reg[0], h.regWrites[h.writeCount - 1]);
+
+    h.writeCount = 0;
+    synth.setFrequency(2904.0);                                 // 88 x 33 MHz: no mode change
+    TEST_ASSERT_EQUAL_UINT32(1, synth.Curr.Reg[0] >> 31);
+    TEST_ASSERT_EQUAL(1, h.writeCount);                         // R0 only
+
+    synth.setFrequency(2400.0);                                 // back to fractional
+    TEST_ASSERT_EQUAL_UINT32(0, synth.Curr.Reg[0] >> 31);
+    TEST_ASSERT_EQUAL_HEX32(r1Frac, synth.Curr.Reg[1] & 0x60000000);
+    TEST_ASSERT_EQUAL_HEX32(r2Frac, synth.Curr.Reg[2] & 0x180);
+    TEST_ASSERT_FLOAT_WITHIN(tolerance, 2400.0, synth.fmn2freq());
+}
+
+// --- Warm start ---
+void test_beginWarm_adopts_locked_image_without_writes(void) {
+    MockHAL h;
+    MAX2871 running(66.0, h, h);
+    running.begin();
+    running.setFrequency(1420.0);
+    MAX2871::max2871Registers saved = running.Curr;     // what the app persisted
+
+    MockHAL h2;
+    h2.locked = true;
+    MAX2871 synth(66.0, h2, h2);
+    TEST_ASSERT_TRUE(synth.beginWarm(saved));
+    TEST_ASSERT_EQUAL(0, h2.writeCount);
+    TEST_ASSERT_EQUAL_HEX32_ARRAY(saved.Reg, synth.Curr.Reg, 6);
+    TEST_ASSERT_EQUAL(running.packedFMN(), synth.packedFMN());
+    TEST_ASSERT_EQUAL(running.DIVA, synth.DIVA);
+    TEST_ASSERT_FLOAT_WITHIN(tolerance, 1420.0, synth.fmn2freq());
+
+    synth.setFrequency(1421.0);                         // normal dirty-mask operation
+    TEST_ASSERT_TRUE(h2.writeCount >= 1 && h2.writeCount <= 2);
+    TEST_ASSERT_EQUAL_HEX32(synth.Curr.Reg[0], h2.regWrites[h2.writeCount - 1]);
+}
+
+void test_beginWarm_falls_back_to_cold_start(void) {
+    MAX2871::max2871Registers saved = MAX2871::defaultRegisters;
+
+    MockHAL unlocked;                                   // no lock on MUXOUT
+    MAX2871 a(66.0, unlocked, unlocked);
+    TEST_ASSERT_FALSE(a.beginWarm(saved));
+    TEST_ASSERT_EQUAL(MockHAL::MAX_WRITES, unlocked.writeCount);
+
+    MockHAL blank;                                      // erased EEPROM
+    blank.locked = true;
+    MAX2871::max2871Registers erased;
+    for (int i = 0; i < 7; i++) erased.Reg[i] = 0xFFFFFFFF;
+    MAX2871 b(66.0, blank, blank);
+    TEST_ASSERT_FALSE(b.beginWarm(erased));
+    TEST_ASSERT_EQUAL_HEX32_ARRAY(MAX2871::defaultRegisters.Reg, b.Curr.Reg, 6);
+
+    MockHAL por;                                        // R6 readback reports POR
+    por.locked = true;
+    por.readback = true;
+    por.reg6 = (1UL << 23) | 6;
+    MAX2871 c(66.0, por, por);
+    TEST_ASSERT_FALSE(c.beginWarm(saved));
+    TEST_ASSERT_EQUAL_HEX32(saved.Reg[5] | (1UL << 18), por.regWrites[0]);  // MUX MSB
+    TEST_ASSERT_EQUAL_HEX32(saved.Reg[2] | (4UL << 26), por.regWrites[1]);  // MUX = 1100
+
+    MockHAL clean;                                      // readback, no POR
+    clean.locked = true;
+    clean.readback = true;
+    MAX2871 d(66.0, clean, clean);
+    TEST_ASSERT_TRUE(d.beginWarm(saved));
+    TEST_ASSERT_EQUAL(4, clean.writeCount);             // MUX there and back only
+    TEST_ASSERT_EQUAL_HEX32(saved.Reg[5], clean.regWrites[3]);
+}
+
+void test_solveNear_prefers_fewer_writes(void) {
+    MockHAL plainHal, nearHal;
+    MAX2871 plain(66.0, plainHal, plainHal);
+    MAX2871 near(66.0, nearHal, nearHal);
+    plain.begin();
+    near.begin();
+    plain.setFrequency(1420.3);
+    near.setFrequency(1420.3);
+
+    uint32_t plainWords = 0, nearWords = 0;
+    for (int i = 1; i <= 100; i++) {
+        double f = 1420.3 + 0.01 * i;
+        plainHal.writeCount = 0;
+        nearHal.writeCount = 0;
+        plain.setFrequency(f);
+        MAX2871::costedSolution c;
+        TEST_ASSERT_TRUE(near.setFrequencyNear(f, 2000.0f, &c));
+        plainWords += plainHal.writeCount;
+        nearWords += nearHal.writeCount;
+
+        TEST_ASSERT_EQUAL(c.cost, nearHal.writeCount);             // reported cost is what went out
+        TEST_ASSERT_TRUE(c.errorHz <= 2000.0f);
+        TEST_ASSERT_FLOAT_WITHIN(0.002, f, near.fmn2freq());
+        TEST_ASSERT_FLOAT_WITHIN(1.0, fabs(near.fmn2freq() - f) * 1e6, c.errorHz);
+    }
+    TEST_ASSERT_TRUE(nearWords < plainWords);
+}
+
+void test_solveNear_out_of_tolerance(void) {
+    MockHAL h;
+    MAX2871 a(66.0, h, h);
+    a.begin();
+    a.setFrequency(1000.0);
+    MAX2871::costedSolution c;
+    TEST_ASSERT_FALSE(a.solveNear(1000.000123, 0.0f, c));        // nothing is exact: best error
+    MAX2871::fmnSolution best;
+    MAX2871::solveFMN(66.0, 1000.000123, best);
+    TEST_ASSERT_TRUE(c.errorHz > 0.0f);
+    TEST_ASSERT_EQUAL(best.M, c.sol.M);
+
+    TEST_ASSERT_TRUE(a.solveNear(1000.0, 1000.0f, c));            // already there: keep it
+    TEST_ASSERT_EQUAL(0, c.cost);
+}
+
+// Costing before begin() reads the shadow of what was written: it must start
+// as the startup image, not whatever the memory held
+void test_solveNear_before_begin_is_deterministic(void) {
+    MockHAL h;
+    alignas(MAX2871) static uint8_t dirty[sizeof(MAX2871)], clean[sizeof(MAX2871)];
+    memset(dirty, 0xA5, sizeof(dirty));
+    memset(clean, 0x00, sizeof(clean));
+    MAX2871* a = new (dirty) MAX2871(66.0, h, h);
+    MAX2871* b = new (clean) MAX2871(66.0, h, h);
+    MAX2871::costedSolution ca, cb;
+    TEST_ASSERT_EQUAL(b->solveNear(1420.0, 1000.0f, cb), a->solveNear(1420.0, 1000.0f, ca));
+    TEST_ASSERT_EQUAL(cb.writes, ca.writes);
+    TEST_ASSERT_EQUAL(cb.cost, ca.cost);
+    TEST_ASSERT_EQUAL(cb.sol.N, ca.sol.N);
+    TEST_ASSERT_EQUAL_HEX32_ARRAY(MAX2871::defaultRegisters.Reg, a->Curr.Reg, 6);
+    TEST_ASSERT_EQUAL(b->writeMask(b->packedFMN(), 3), a->writeMask(a->packedFMN(), 3));
+    a->~MAX2871();
+    b->~MAX2871();
+}
+
+void test_octave_jump_writes_only_R4(void) {
+    MockHAL h, ref;
+    MAX2871 a(66.0, h, h);
+    MAX2871 solved(66.0, ref, ref);
+    a.begin();
+    solved.begin();
+    a.setFrequency(1420.3);
+    const double octaves[] = {710.15, 88.76875, 2840.6, 1420.3};
+    for (auto f : octaves) {
+        h.writeCount = 0;
+        a.setFrequency(f);
+        TEST_ASSERT_EQUAL(1, h.writeCount);                        // R4 alone: no R0, no autocal
+        TEST_ASSERT_EQUAL_UINT32(4, h.regWrites[0] & 0x7);
+        solved.setFrequency(f);                                    // same words as a full solve
+        TEST_ASSERT_EQUAL_HEX32_ARRAY(solved.Curr.Reg, a.Curr.Reg, 6);
+        TEST_ASSERT_FLOAT_WITHIN(tolerance, f, a.fmn2freq());
+    }
+
+    h.writeCount = 0;
+    a.setFrequency(710.1504);                                      // near-octave: solved by default
+    TEST_ASSERT_EQUAL_UINT32(0, h.regWrites[h.writeCount - 1] & 0x7);
+    a.setFrequency(1420.3);
+    a.setOctaveTolerance(500.0f);
+    h.writeCount = 0;
+    a.setFrequency(710.1504);
+    TEST_ASSERT_EQUAL(1, h.writeCount);
+    TEST_ASSERT_FLOAT_WITHIN(0.0005, 710.15, a.fmn2freq());
+
+    // The tolerance applies to the output the chip makes, not the target asked for
+    a.setFrequency(3001.7777);
+    double errHz = (a.fmn2freq() - 3001.7777) * 1e6;
+    a.setOctaveTolerance(fabs(errHz));
+    double near = 3001.7777 / 2 - (errHz > 0 ? 1 : -1) * 0.9 * fabs(errHz) * 1e-6;
+    h.writeCount = 0;
+    a.setFrequency(near);                                          // target within, output not
+    TEST_ASSERT_EQUAL_UINT32(0, h.regWrites[h.writeCount - 1] & 0x7);
+
+    a.setOctaveTolerance(500.0f);
+    a.setFrequency(1420.3);
+    a.setRegister(a.Curr.Reg[4] & ~(1UL << 23));                   // FB = 0: DIVA is inside the loop
+    h.writeCount = 0;
+    a.setFrequency(710.1504);
+    TEST_ASSERT_EQUAL_UINT32(0, h.regWrites[h.writeCount - 1] & 0x7);
+    a.setRegister(a.Curr.Reg[4] | (1UL << 23));
+    a.setOctaveTolerance(0);
+    a.setFrequency(710.15);
+
+    a.setDoubleBuffer(true);                                       // DIVA now waits for R0
+    h.writeCount = 0;
+    a.setOutputDivider(2);
+    TEST_ASSERT_EQUAL(2, h.writeCount);
+    TEST_ASSERT_EQUAL_UINT32(0, h.regWrites[1] & 0x7);
+    TEST_ASSERT_EQUAL(2, a.DIVA);
+    h.writeCount = 0;
+    a.setOutputDivider(8);                                         // out of range: ignored
+    TEST_ASSERT_EQUAL(0, h.writeCount);
+}
+
+// A concrete transport type, as BoardTransport is on the boards
+class DirectHAL final : public MockHAL {
+public:
+    uint8_t batches = 0;
+    void spiWriteRegisters(const uint32_t* values, uint8_t count) override {
+        batches++;
+        MockHAL::spiWriteRegisters(values, count);
+    }
+};
+
+void test_direct_path_writes_same_words(void) {
+    MockHAL h;
+    DirectHAL d;
+    MAX2871 a(66.0, h, h);
+    MAX2871 b(66.0, d, d);
+    a.begin();
+    b.begin();
+    d.batches = 0;
+
+    const double hops[] = {2400.0, 2400.5, 1200.25, 4129.392};
+    for (double f : hops) {
+        h.writeCount = 0;
+        d.writeCount = 0;
+        a.setFrequency(f);
+        b.setFrequency(f, d);
+        TEST_ASSERT_EQUAL(h.writeCount, d.writeCount);
+        TEST_ASSERT_EQUAL_UINT32_ARRAY(h.regWrites, d.regWrites, h.writeCount);
+    }
+    TEST_ASSERT_EQUAL(4, d.batches);
+
+    h.writeCount = 0;
+    d.writeCount = 0;
+    a.setFrequency(b.packedFMN(), 2);
+    b.setFrequency(b.packedFMN(), 2, d);
+    TEST_ASSERT_EQUAL(h.writeCount, d.writeCount);
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(h.regWrites, d.regWrites, h.writeCount);
+
+    DirectHAL other;                                               // not this driver's transport
+    d.writeCount = 0;
+    b.setFrequency(3000.0, other);
+    TEST_ASSERT_EQUAL(0, other.writeCount);
+    TEST_ASSERT_TRUE(d.writeCount > 0);
+}
+
 void runAllTests(void) {
     UNITY_BEGIN();
     RUN_TEST(test_round_trip_known);
@@ -109,8 +477,21 @@ void runAllTests(void) {
     RUN_TEST(test_highest_freq);
     RUN_TEST(test_integerN_case);
     RUN_TEST(test_param_round_trip);
+    RUN_TEST(test_sweep_flags_unreachable_points);
+    RUN_TEST(test_static_image_matches_setFrequency);
+    RUN_TEST(test_static_image_output_fields);
     RUN_TEST(test_interface_begin_and_setFrequency);
     RUN_TEST(test_outputSelect_marks_R4_only_and_sets_expected_bits);
+    RUN_TEST(test_mute_until_lock_costs_no_extra_writes_per_hop);
+    RUN_TEST(test_standby_and_wake_keep_shadow);
+    RUN_TEST(test_integer_n_mode_follows_frac);
+    RUN_TEST(test_beginWarm_adopts_locked_image_without_writes);
+    RUN_TEST(test_solveNear_prefers_fewer_writes);
+    RUN_TEST(test_solveNear_out_of_tolerance);
+    RUN_TEST(test_solveNear_before_begin_is_deterministic);
+    RUN_TEST(test_octave_jump_writes_only_R4);
+    RUN_TEST(test_beginWarm_falls_back_to_cold_start);
+    RUN_TEST(test_direct_path_writes_same_words);
     UNITY_END();
 }
 
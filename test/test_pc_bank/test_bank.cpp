@@ -0,0 +1,165 @@
+#ifdef ARDUINO
+  #include <Arduino.h>
+#endif
+#include <unity.h>
+#include "max2871.h"
+#include "max2871_bank.h"
+#include "max2871_transport.h"
+
+// ---- Shared bus: N chips, each latching the words its LE saw ----
+
+static const uint8_t CHIPS = 3;
+
+class BankBus : public IDelayProvider, public I_MAX2871BankTransport {
+public:
+    uint32_t latched[CHIPS][6];
+    uint16_t words = 0;                 // words shifted on the bus
+    uint16_t latches = 0;               // LE pulses, summed over chips
+    uint8_t delays = 0;
+    uint8_t lastMask = 0;
+
+    void delayMs(uint32_t) override { delays++; }
+    bool readMuxout(uint8_t chip) override { return chip != 1; }
+
+    void spiWriteRegister(uint32_t value, uint8_t leMask) override {
+        words++;
+        lastMask = leMask;
+        for (uint8_t c = 0; c < CHIPS; c++) {
+            if (leMask & (1 << c)) {
+                latched[c][value & 0x7] = value;
+                latches++;
+            }
+        }
+    }
+
+    void clear() { words = latches = delays = 0; }
+};
+
+// Single-chip bus, to program standalone MAX2871s with the same requests
+class CountingBus : public IDelayProvider, public I_MAX2871Transport {
+public:
+    uint16_t words = 0;
+    void delayMs(uint32_t) override {}
+    bool readMuxout() override { return true; }
+    void spiWriteRegister(uint32_t) override { words++; }
+};
+
+static BankBus bus;
+static MAX2871Bank<CHIPS> bank(66.0, bus, bus);
+static CountingBus single[CHIPS];
+static MAX2871 ref0(66.0, single[0], single[0]);
+static MAX2871 ref1(66.0, single[1], single[1]);
+static MAX2871 ref2(66.0, single[2], single[2]);
+static MAX2871* refs[CHIPS] = {&ref0, &ref1, &ref2};
+
+static void beginAll() {
+    bank.begin();
+    bus.clear();
+    for (uint8_t c = 0; c < CHIPS; c++) {
+        refs[c]->begin();
+        single[c].words = 0;
+    }
+}
+
+static uint16_t singleWords() {
+    return single[0].words + single[1].words + single[2].words;
+}
+
+static void assertChipsMatchStandalone() {
+    for (uint8_t c = 0; c < CHIPS; c++) {
+        TEST_ASSERT_EQUAL_HEX32_ARRAY(refs[c]->Curr.Reg, bus.latched[c], 6);
+        for (uint8_t r = 0; r < 6; r++) TEST_ASSERT_EQUAL_HEX32(refs[c]->Curr.Reg[r], bank.reg(c, r));
+    }
+}
+
+void setUp(void) {
+    beginAll();
+}
+
+void tearDown(void) {}
+
+void test_begin_is_broadcast(void) {
+    bus.clear();
+    bank.begin();
+    TEST_ASSERT_EQUAL(12, bus.words);                   // vs 36 writing each chip in turn
+    TEST_ASSERT_EQUAL(36, bus.latches);
+    TEST_ASSERT_EQUAL(1, bus.delays);
+    TEST_ASSERT_EQUAL_HEX8(0x07, bus.lastMask);
+    assertChipsMatchStandalone();
+}
+
+void test_per_chip_tuning_matches_standalone(void) {
+    const double freqs[CHIPS] = {2400.0, 2410.0, 1420.0};
+    for (uint8_t c = 0; c < CHIPS; c++) {
+        bank.setFrequency(c, freqs[c]);
+        refs[c]->setFrequency(freqs[c]);
+    }
+    TEST_ASSERT_EQUAL(0, bus.words);                    // staged only
+    bank.update();
+    assertChipsMatchStandalone();
+    TEST_ASSERT_TRUE(bus.words < singleWords());        // shared R4 goes out once
+    for (uint8_t c = 0; c < CHIPS; c++) {
+        TEST_ASSERT_FLOAT_WITHIN(0.002, freqs[c], bank.fmn2freq(c));
+    }
+    TEST_ASSERT_EQUAL(0, bank.update());                // nothing left to write
+}
+
+void test_identical_chips_cost_one_chip(void) {
+    for (uint8_t c = 0; c < CHIPS; c++) bank.setFrequency(c, 1420.0);
+    ref0.setFrequency(1420.0);
+    uint8_t words = bank.update();
+    TEST_ASSERT_EQUAL(single[0].words, words);
+    TEST_ASSERT_EQUAL_HEX8(0x07, bus.lastMask);
+}
+
+void test_output_changes_and_packed_tuning(void) {
+    bank.outputPower(1, -1, RF_A);
+    bank.outputSelect(2, RF_B);
+    bank.setFrequency(0, ref0.packedFMN(), 3);
+    ref1.outputPower(-1, RF_A);
+    ref2.outputSelect(RF_B);
+    ref0.setFrequency(ref0.packedFMN(), 3);
+    bank.update();
+    assertChipsMatchStandalone();
+    TEST_ASSERT_TRUE(bank.isLocked(0));
+    TEST_ASSERT_FALSE(bank.isLocked(1));
+}
+
+void test_startup_image_is_copied(void) {
+    MAX2871::max2871Registers image = MAX2871::defaultRegisters;
+    MAX2871Bank<CHIPS> own(66.0, bus, bus, image);
+    for (uint8_t r = 0; r < 6; r++) image.Reg[r] = 0xDEAD0000UL | r;    // caller reuses its copy
+    own.begin();
+    for (uint8_t c = 0; c < CHIPS; c++) {
+        for (uint8_t r = 0; r < 6; r++) TEST_ASSERT_EQUAL_HEX32(MAX2871::defaultRegisters.Reg[r], own.reg(c, r));
+    }
+}
+
+void test_bank_is_smaller_than_separate_objects(void) {
+    TEST_ASSERT_TRUE(sizeof(MAX2871Bank<CHIPS>) < CHIPS * sizeof(MAX2871));
+}
+
+void runAllTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_begin_is_broadcast);
+    RUN_TEST(test_per_chip_tuning_matches_standalone);
+    RUN_TEST(test_identical_chips_cost_one_chip);
+    RUN_TEST(test_output_changes_and_packed_tuning);
+    RUN_TEST(test_startup_image_is_copied);
+    RUN_TEST(test_bank_is_smaller_than_separate_objects);
+    UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    delay(2000);
+    runAllTests();
+}
+void loop() { delay(1000); }
+#else
+int main(void) {
+    runAllTests();
+    return 0;
+}
+#endif
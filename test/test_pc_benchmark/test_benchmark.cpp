@@ -0,0 +1,97 @@
+#ifdef ARDUINO
+  #include <Arduino.h>
+#endif
+#include <unity.h>
+#include <string.h>
+#include "max2871.h"
+#include "max2871_benchmark.h"
+
+// ---- Stand-ins ----
+
+// Counts words per register address
+class CountingBus : public I_MAX2871Transport, public IDelayProvider {
+public:
+    uint32_t perReg[8] = {0};
+
+    void delayMs(uint32_t) override {}
+    bool readMuxout() override { return true; }
+    void spiWriteRegister(uint32_t value) override {
+        perReg[value & 0x7]++;
+    }
+    void clear() {
+        memset(perReg, 0, sizeof(perReg));
+    }
+};
+
+// Every read moves the clock 1000 us on: each op totals exactly 1000 us
+static uint32_t fakeNow;
+static uint32_t fakeClock() {
+    uint32_t t = fakeNow;
+    fakeNow += 1000;
+    return t;
+}
+
+static char report[1024];
+static void capture(const char* text) {
+    strncat(report, text, sizeof(report) - strlen(report) - 1);
+}
+
+void setUp(void) {
+    fakeNow = 0xFFFFF000UL;                 // wraps during the run
+    report[0] = '\0';
+}
+void tearDown(void) {}
+
+void test_report_is_fixed_format(void) {
+    CountingBus bus;
+    MAX2871 lo(66.0, bus, bus);
+    lo.begin();
+    max2871bench::Harness bench(lo, bus, fakeClock, capture);
+    bench.run("test", 8);
+
+    TEST_ASSERT_EQUAL_STRING(
+        "# MAX2871 benchmark board=test ref_mhz=66 reps=8\n"
+        "op=freq2FMN total_us=1000 ns_per_op=125000 per_s=8000\n"
+        "op=setFrequency total_us=1000 ns_per_op=125000 per_s=8000\n"
+        "op=updateRegister total_us=1000 ns_per_op=125000 per_s=8000\n"
+        "op=updateAll total_us=1000 ns_per_op=125000 per_s=8000\n"
+        "op=spiWriteRegister total_us=1000 ns_per_op=125000 per_s=8000\n"
+        "# done\n",
+        report);
+}
+
+void test_every_repetition_writes(void) {
+    CountingBus bus;
+    MAX2871 lo(66.0, bus, bus);
+    lo.begin();
+    max2871bench::Harness bench(lo, bus, fakeClock, capture);
+    bus.clear();
+    bench.run("test", 10);
+
+    // 10 repetitions + 1 warm-up each. R0: setFrequency and updateAll;
+    // R4: updateRegister and updateAll; R5: updateAll and spiWriteRegister
+    TEST_ASSERT_EQUAL_UINT32(11 + 11, bus.perReg[0]);
+    TEST_ASSERT_TRUE(bus.perReg[4] >= 11 + 11);
+    TEST_ASSERT_EQUAL_UINT32(11 + 11, bus.perReg[5]);
+}
+
+void runAllTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_report_is_fixed_format);
+    RUN_TEST(test_every_repetition_writes);
+    UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    delay(2000);
+    runAllTests();
+}
+void loop() { delay(1000); }
+#else
+int main(void) {
+    runAllTests();
+    return 0;
+}
+#endif
@@ -0,0 +1,217 @@
+#ifdef ARDUINO
+  #include <Arduino.h>
+#endif
+#include <unity.h>
+#include <math.h>
+#include "max2871.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+#ifndef ARDUINO
+#include "max2871_capi.h"
+
+// ---- Stand-ins ----
+
+// Records every word the reference driver writes
+class RecordingBus : public I_MAX2871Transport, public IDelayProvider {
+public:
+    uint32_t words[256];
+    size_t count = 0;
+
+    void delayMs(uint32_t) override {}
+    bool readMuxout() override { return true; }
+    void spiWriteRegister(uint32_t value) override {
+        if (count < 256) words[count++] = value;
+    }
+};
+
+static const double REF = 66.0;
+static const double FREQS[] = {23.5, 100.0, 433.92, 1000.0, 2400.0, 2450.0, 4900.0, 5999.9};
+static const size_t COUNT = sizeof(FREQS) / sizeof(FREQS[0]);
+
+void test_solve_matches_driver(void) {
+    uint32_t fmn[COUNT];
+    uint8_t diva[COUNT];
+    TEST_ASSERT_EQUAL(0, max2871_solve(REF, FREQS, COUNT, fmn, diva));
+    for (size_t i = 0; i < COUNT; i++) {
+        MAX2871::fmnSolution sol;
+        MAX2871::solveFMN(REF, (float)FREQS[i], sol);
+        TEST_ASSERT_EQUAL_UINT32(((uint32_t)sol.Frac << 20) | ((uint32_t)sol.M << 8) | sol.N, fmn[i]);
+        TEST_ASSERT_EQUAL_UINT8(sol.DIVA, diva[i]);
+    }
+
+    double back[COUNT];
+    TEST_ASSERT_EQUAL(0, max2871_fmn_to_freq(REF, fmn, diva, COUNT, back));
+    for (size_t i = 0; i < COUNT; i++) TEST_ASSERT_TRUE(fabs(back[i] - FREQS[i]) < 1e-3);
+}
+
+void test_images_match_driver_registers(void) {
+    uint32_t images[COUNT * 6];
+    TEST_ASSERT_EQUAL(0, max2871_images(REF, NULL, FREQS, COUNT, images));
+    for (size_t i = 0; i < COUNT; i++) {
+        RecordingBus bus;
+        MAX2871 lo(REF, bus, bus);
+        lo.adoptImage(MAX2871::defaultRegisters);
+        lo.setFrequency(FREQS[i]);
+        TEST_ASSERT_EQUAL_UINT32_ARRAY(lo.Curr.Reg, &images[i * 6], 6);
+    }
+
+    double back[COUNT];
+    TEST_ASSERT_EQUAL(0, max2871_image_to_freq(REF, images, COUNT, back));
+    for (size_t i = 0; i < COUNT; i++) TEST_ASSERT_TRUE(fabs(back[i] - FREQS[i]) < 1e-3);
+
+    // R = 2 in R2 halves the comparison frequency
+    uint32_t halved[6];
+    for (uint8_t r = 0; r < 6; r++) halved[r] = images[6 + r];
+    halved[2] = (halved[2] & ~(0x3FFu << 14)) | (2u << 14);
+    TEST_ASSERT_EQUAL(0, max2871_image_to_freq(REF, halved, 1, back));
+    TEST_ASSERT_TRUE(fabs(back[0] - FREQS[1] / 2) < 1e-3);
+}
+
+void test_plan_writes_matches_driver(void) {
+    RecordingBus bus;
+    MAX2871 lo(REF, bus, bus);
+    lo.adoptImage(MAX2871::defaultRegisters);
+    uint8_t expected[COUNT];
+    for (size_t i = 0; i < COUNT; i++) {
+        size_t before = bus.count;
+        lo.setFrequency(FREQS[i]);
+        expected[i] = (uint8_t)(bus.count - before);
+    }
+
+    uint32_t words[256];
+    uint8_t perPoint[COUNT];
+    size_t used = 0;
+    TEST_ASSERT_EQUAL(0, max2871_plan_writes(REF, NULL, FREQS, COUNT, words, 256, perPoint, &used));
+    TEST_ASSERT_EQUAL_UINT32(bus.count, used);
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(bus.words, words, used);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, perPoint, COUNT);
+
+    TEST_ASSERT_EQUAL(MAX2871_CAPI_E_SPACE,
+                      max2871_plan_writes(REF, NULL, FREQS, COUNT, words, used - 1, perPoint, &used));
+}
+
+void test_other_references_and_n_limit(void) {
+    // 50 MHz: N stays under 120, every point solves and decodes back
+    uint32_t fmn[COUNT];
+    uint8_t diva[COUNT];
+    uint32_t images[COUNT * 6];
+    double back[COUNT];
+    TEST_ASSERT_EQUAL(0, max2871_solve(50.0, FREQS, COUNT, fmn, diva));
+    TEST_ASSERT_EQUAL(0, max2871_fmn_to_freq(50.0, fmn, diva, COUNT, back));
+    for (size_t i = 0; i < COUNT; i++) TEST_ASSERT_TRUE(fabs(back[i] - FREQS[i]) < 1e-3);
+    TEST_ASSERT_EQUAL(0, max2871_images(50.0, NULL, FREQS, COUNT, images));
+    TEST_ASSERT_EQUAL(0, max2871_image_to_freq(50.0, images, COUNT, back));
+    for (size_t i = 0; i < COUNT; i++) TEST_ASSERT_TRUE(fabs(back[i] - FREQS[i]) < 1e-3);
+
+    // 20 MHz: VCOs above 5100 MHz need N > 255 and are refused, not truncated
+    const double low[4] = {2400.0, 5000.0, 2590.0, 5900.0};     // VCO 4800, 5000, 5180, 5900
+    uint32_t lowImages[4 * 6];
+    TEST_ASSERT_EQUAL(2, max2871_solve(20.0, low, 4, fmn, diva));
+    TEST_ASSERT_EQUAL_UINT8(0xFF, diva[2]);
+    TEST_ASSERT_EQUAL_UINT8(0xFF, diva[3]);
+    TEST_ASSERT_EQUAL(0, max2871_fmn_to_freq(20.0, fmn, diva, 2, back));
+    TEST_ASSERT_TRUE(fabs(back[0] - 2400.0) < 1e-3);
+    TEST_ASSERT_TRUE(fabs(back[1] - 5000.0) < 1e-3);
+    TEST_ASSERT_EQUAL(2, max2871_images(20.0, NULL, low, 4, lowImages));
+    TEST_ASSERT_EQUAL_UINT32(0, lowImages[2 * 6]);
+    TEST_ASSERT_EQUAL(0, max2871_image_to_freq(20.0, lowImages, 2, back));
+    TEST_ASSERT_TRUE(fabs(back[1] - 5000.0) < 1e-3);
+
+    uint32_t words[64];
+    uint8_t perPoint[4];
+    size_t used = 0;
+    TEST_ASSERT_EQUAL(2, max2871_plan_writes(20.0, NULL, low, 4, words, 64, perPoint, &used));
+    TEST_ASSERT_EQUAL_UINT8(0, perPoint[2]);
+    TEST_ASSERT_EQUAL_UINT8(0, perPoint[3]);
+
+    // 10 MHz cannot reach the bottom of the VCO range with 8-bit N
+    const double ten[2] = {5000.0, 2400.0};
+    TEST_ASSERT_EQUAL(2, max2871_solve(10.0, ten, 2, fmn, diva));
+}
+
+void test_start_must_not_divide_the_reference(void) {
+    // R = 2, DBR or RDIV2 in the start image would halve or double what was solved for
+    const uint32_t bits[3] = {2u << 14, 1u << 25, 1u << 24};
+    const double f = 2400.0;
+    uint32_t image[6], words[16];
+    uint8_t perPoint[1];
+    size_t used;
+    for (uint8_t b = 0; b < 3; b++) {
+        uint32_t start[6];
+        for (uint8_t r = 0; r < 6; r++) start[r] = MAX2871::defaultRegisters.Reg[r];
+        start[2] = (start[2] & ~0x03FFC000u) | (1u << 14) | bits[b];
+        TEST_ASSERT_EQUAL(MAX2871_CAPI_E_IMAGE, max2871_images(REF, start, &f, 1, image));
+        TEST_ASSERT_EQUAL(MAX2871_CAPI_E_IMAGE,
+                          max2871_plan_writes(REF, start, &f, 1, words, 16, perPoint, &used));
+    }
+
+    // With R = 1 the image decodes back to the request
+    uint32_t start[6];
+    for (uint8_t r = 0; r < 6; r++) start[r] = MAX2871::defaultRegisters.Reg[r];
+    start[2] = (start[2] & ~0x03FFC000u) | (1u << 14);
+    double back;
+    TEST_ASSERT_EQUAL(0, max2871_images(REF, start, &f, 1, image));
+    TEST_ASSERT_EQUAL(0, max2871_image_to_freq(REF, image, 1, &back));
+    TEST_ASSERT_TRUE(fabs(back - f) < 1e-3);
+}
+
+void test_bad_arguments(void) {
+    uint32_t fmn[3];
+    uint8_t diva[3];
+    uint32_t images[18];
+    const double mixed[3] = {10.0, 1000.0, 7000.0};
+
+    TEST_ASSERT_EQUAL_UINT32(MAX2871_CAPI_VERSION, max2871_capi_version());
+    TEST_ASSERT_EQUAL(MAX2871_CAPI_E_ARGS, max2871_solve(REF, NULL, 3, fmn, diva));
+    TEST_ASSERT_EQUAL(MAX2871_CAPI_E_REFERENCE, max2871_solve(5.0, mixed, 3, fmn, diva));
+
+    // Out-of-range points are counted and marked, the rest still solved
+    TEST_ASSERT_EQUAL(2, max2871_solve(REF, mixed, 3, fmn, diva));
+    TEST_ASSERT_EQUAL_UINT32(0, fmn[0]);
+    TEST_ASSERT_EQUAL_UINT8(0xFF, diva[2]);
+    TEST_ASSERT_TRUE(fmn[1] != 0);
+    TEST_ASSERT_EQUAL(2, max2871_images(REF, NULL, mixed, 3, images));
+    TEST_ASSERT_EQUAL_UINT32(0, images[0]);
+    TEST_ASSERT_TRUE(images[6] != 0);
+
+    // A word must carry its own register address
+    uint32_t start[6];
+    for (uint8_t r = 0; r < 6; r++) start[r] = MAX2871::defaultRegisters.Reg[r];
+    start[3] = start[4];
+    TEST_ASSERT_EQUAL(MAX2871_CAPI_E_IMAGE, max2871_images(REF, start, mixed, 3, images));
+}
+
+void runAllTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_solve_matches_driver);
+    RUN_TEST(test_images_match_driver_registers);
+    RUN_TEST(test_plan_writes_matches_driver);
+    RUN_TEST(test_other_references_and_n_limit);
+    RUN_TEST(test_start_must_not_divide_the_reference);
+    RUN_TEST(test_bad_arguments);
+    UNITY_END();
+}
+
+#else
+// The C ABI is host-only
+void runAllTests(void) {
+    UNITY_BEGIN();
+    UNITY_END();
+}
+#endif
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    delay(2000);
+    runAllTests();
+}
+void loop() { delay(1000); }
+#else
+int main(void) {
+    runAllTests();
+    return 0;
+}
+#endif
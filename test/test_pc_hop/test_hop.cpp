@@ -0,0 +1,186 @@
+#ifdef ARDUINO
+  #include <Arduino.h>
+#endif
+#include <unity.h>
+#include "max2871.h"
+#include "max2871_hop.h"
+
+// ---- Stand-in clock and bus: every word costs 'usPerWord' of bus time ----
+
+class ClockedBus : public I_MAX2871Transport {
+public:
+    uint32_t now = 0;
+    uint32_t usPerWord = 0;
+    uint32_t chip[6];
+    uint32_t words = 0;
+    uint32_t batches = 0;
+
+    bool readMuxout() override { return true; }
+    void spiWriteRegister(uint32_t value) override {
+        chip[value & 0x7] = value;
+        words++;
+        now += usPerWord;
+    }
+    void spiWriteRegisters(const uint32_t* values, uint8_t n) override {
+        batches++;
+        for (uint8_t i = 0; i < n; i++) spiWriteRegister(values[i]);
+    }
+};
+
+static const uint16_t HOPS = 64;
+static uint32_t words[HOPS * 6];
+static uint16_t ends[HOPS + 1];
+static MAX2871HopTable table(words, sizeof(words) / sizeof(words[0]), ends, HOPS + 1);
+static MAX2871 shadow(66.0, table, table);
+static double hopMHz[HOPS];
+
+void setUp(void) {
+    table.clear();
+    shadow.begin();
+    table.clear();                                          // drop the startup words
+    for (uint16_t i = 0; i < HOPS; i++) {
+        hopMHz[i] = 2400.0 + 1.25 * ((i * 37) % HOPS);      // scrambled 1.25 MHz channels
+        TEST_ASSERT_TRUE(table.add(shadow, hopMHz[i]));
+    }
+}
+
+void tearDown(void) {}
+
+static void startChip(ClockedBus& bus) {
+    for (uint8_t r = 0; r < 6; r++) bus.chip[r] = MAX2871::defaultRegisters.Reg[r];
+    bus.words = 0;
+    bus.batches = 0;
+}
+
+void test_table_holds_what_the_driver_writes(void) {
+    TEST_ASSERT_EQUAL(HOPS, table.hops());
+    uint16_t total = 0;
+    for (uint16_t i = 0; i < HOPS; i++) {
+        TEST_ASSERT_TRUE(table.hopLength(i) >= 1);
+        TEST_ASSERT_EQUAL_UINT32(0, table.hopWords(i)[table.hopLength(i) - 1] & 0x7);   // R0 last
+        total += table.hopLength(i);
+    }
+    TEST_ASSERT_EQUAL(total, table.words());
+}
+
+void test_exact_ticks_play_every_hop_on_time(void) {
+    ClockedBus bus;
+    startChip(bus);
+    MAX2871HopPlayer player(bus, table);
+    player.start(1000, 100);
+    uint16_t hop = 0;
+    MAX2871 model(66.0, bus, table);                        // solver only
+    for (uint32_t t = 1000; player.running(); t += 100) {
+        bus.now = t;
+        TEST_ASSERT_TRUE(player.tick(t));
+        TEST_ASSERT_FALSE(player.tick(t + 50));             // mid-slot tick: nothing due
+        model.freq2FMN(hopMHz[hop++]);
+        TEST_ASSERT_EQUAL_UINT16(model.N, (bus.chip[0] >> 15) & 0xFFFF);
+        TEST_ASSERT_EQUAL_UINT16(model.Frac, (bus.chip[0] >> 3) & 0xFFF);
+    }
+    const MAX2871HopPlayer::Stats& s = player.stats();
+    TEST_ASSERT_EQUAL(HOPS, s.played);
+    TEST_ASSERT_EQUAL(HOPS, bus.batches);                   // one transport batch per hop
+    TEST_ASSERT_EQUAL(0, s.late);
+    TEST_ASSERT_EQUAL(0, s.missed);
+    TEST_ASSERT_EQUAL(0, s.jitterUs());
+    TEST_ASSERT_EQUAL(100, s.minIntervalUs);
+    TEST_ASSERT_EQUAL_HEX32_ARRAY(shadow.Curr.Reg, bus.chip, 6);
+}
+
+void test_sustained_rate_with_isr_latency(void) {
+    // Polled every 4 us with a scripted 0..12 us interrupt latency and 3 us/word on the bus
+    ClockedBus bus;
+    bus.usPerWord = 3;
+    startChip(bus);
+    MAX2871HopPlayer player(bus, table);
+    player.start(0, 100, 10);
+    uint32_t lastHopAt = 0;
+    for (uint32_t t = 0; player.running() && t < 20000; t += 4) {
+        uint32_t latency = (t / 4 * 7) % 13;
+        if (bus.now < t + latency) bus.now = t + latency;
+        if (player.tick(bus.now)) lastHopAt = bus.now;
+    }
+    const MAX2871HopPlayer::Stats& s = player.stats();
+    TEST_ASSERT_EQUAL(HOPS, s.played);
+    TEST_ASSERT_EQUAL(0, s.missed);
+    TEST_ASSERT_TRUE(s.maxLateUs <= 16);
+    TEST_ASSERT_TRUE(s.jitterUs() <= 32);
+    TEST_ASSERT_TRUE(lastHopAt < (uint32_t)HOPS * 100);      // 10 kHop/s sustained
+}
+
+void test_slow_bus_counts_late_and_missed(void) {
+    ClockedBus bus;
+    bus.usPerWord = 70;                                     // an R1 + R0 hop outlasts its slot
+    startChip(bus);
+    MAX2871HopPlayer player(bus, table);
+    player.start(0, 100, 20);
+    while (player.running()) player.tick(bus.now++);
+    const MAX2871HopPlayer::Stats& s = player.stats();
+    TEST_ASSERT_EQUAL(HOPS, s.played);                      // every hop still reaches the chip
+    TEST_ASSERT_TRUE(s.late > 0);
+    TEST_ASSERT_TRUE(s.missed > 0);
+    TEST_ASSERT_TRUE(s.maxIntervalUs > 100);
+    TEST_ASSERT_EQUAL_HEX32_ARRAY(shadow.Curr.Reg, bus.chip, 6);
+}
+
+void test_loop_and_clock_wrap(void) {
+    TEST_ASSERT_TRUE(table.closeLoop(shadow));
+    TEST_ASSERT_FALSE(table.add(shadow, 1000.0));           // closed
+    ClockedBus bus;
+    startChip(bus);
+    MAX2871HopPlayer player(bus, table);
+    uint32_t t = 0xFFFFFFFFUL - 50 * 100;                   // micros() wraps mid-run
+    player.start(t, 100);
+    uint32_t chipAfterFirst[6];
+    for (uint16_t i = 0; i < 3 * HOPS; i++, t += 100) {
+        TEST_ASSERT_TRUE(player.tick(t));
+        if (i == 0) for (uint8_t r = 0; r < 6; r++) chipAfterFirst[r] = bus.chip[r];
+        if (i == HOPS) TEST_ASSERT_EQUAL_HEX32_ARRAY(chipAfterFirst, bus.chip, 6);  // closing hop = hop 0
+    }
+    TEST_ASSERT_TRUE(player.running());
+    TEST_ASSERT_EQUAL(0, player.stats().missed);
+    TEST_ASSERT_EQUAL(0, player.stats().jitterUs());
+    player.stop();
+    TEST_ASSERT_FALSE(player.tick(t));
+}
+
+void test_full_table_rolls_back(void) {
+    uint32_t small[8];
+    uint16_t smallEnds[4];
+    MAX2871HopTable tiny(small, 8, smallEnds, 4);
+    MAX2871 s(66.0, tiny, tiny);
+    s.begin();
+    tiny.clear();
+    uint16_t added = 0;
+    while (tiny.add(s, 1000.0 + 7.3 * added)) added++;
+    TEST_ASSERT_TRUE(added >= 1 && added <= 4);
+    TEST_ASSERT_TRUE(tiny.words() <= 8);
+    s.freq2FMN(1000.0 + 7.3 * (added - 1));                 // shadow still on the last stored hop
+    TEST_ASSERT_EQUAL_UINT16(s.N, (s.Curr.Reg[0] >> 15) & 0xFFFF);
+}
+
+void runAllTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_table_holds_what_the_driver_writes);
+    RUN_TEST(test_exact_ticks_play_every_hop_on_time);
+    RUN_TEST(test_sustained_rate_with_isr_latency);
+    RUN_TEST(test_slow_bus_counts_late_and_missed);
+    RUN_TEST(test_loop_and_clock_wrap);
+    RUN_TEST(test_full_table_rolls_back);
+    UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    delay(2000);
+    runAllTests();
+}
+void loop() { delay(1000); }
+#else
+int main(void) {
+    runAllTests();
+    return 0;
+}
+#endif
@@ -0,0 +1,168 @@
+#ifdef ARDUINO
+  #include <Arduino.h>
+#endif
+#include <unity.h>
+#include <math.h>
+#include "max2871.h"
+#include "if_planner.h"
+
+// ---- Stand-ins ----
+
+// Counts words and relocks (an R0 write restarts the lock) per chip
+class CountingBus : public I_MAX2871Transport, public IDelayProvider {
+public:
+    uint32_t words = 0;
+    uint32_t relocks = 0;
+
+    void delayMs(uint32_t) override {}
+    bool readMuxout() override { return true; }
+    void spiWriteRegister(uint32_t value) override {
+        words++;
+        if ((value & 0x7) == 0) relocks++;
+    }
+};
+
+// Any I_PLLSynthesizer: remembers the last frequency and counts tunes
+class FakeSynth : public I_PLLSynthesizer {
+public:
+    double freqMHz = 0;
+    uint32_t tunes = 0;
+
+    void begin() override {}
+    void setFrequency(double f) override { freqMHz = f; tunes++; }
+    void setFrequency(uint32_t, uint8_t) override {}
+    void outputSelect(RFOutPort) override {}
+    void outputPower(int, RFOutPort) override {}
+    bool isLocked() override { return true; }
+};
+
+static const IfPlanner::Config cfg = {1000.0, 1200.0, 25.0, 240.0, 10.7, 23.5, 6000.0, 30.0};
+static IfPlanner planner(cfg);
+static IfPlanner::Segment seg[16];
+
+#ifdef ARDUINO
+static const double STEP = 25.0;
+#else
+static const double STEP = 1.0;
+#endif
+static const double START = 50.0, STOP = 5900.0;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_segments_cover_the_sweep(void) {
+    uint8_t n = planner.plan(START, STOP, STEP, seg, 16);
+    TEST_ASSERT_TRUE(n > 0);
+    uint32_t next = 0;
+    for (uint8_t s = 0; s < n; s++) {
+        TEST_ASSERT_EQUAL_UINT32(next, seg[s].firstPoint);
+        TEST_ASSERT_TRUE(seg[s].points > 0);
+        next += seg[s].points;
+        for (uint32_t k = 0; k < seg[s].points; k++) {
+            double rf = START + (seg[s].firstPoint + k) * STEP;
+            double lo1 = IfPlanner::lo1For(seg[s], rf);
+            TEST_ASSERT_TRUE(lo1 >= cfg.loMinMHz && lo1 <= cfg.loMaxMHz);
+            TEST_ASSERT_TRUE(fabs(rf - seg[s].if1MHz) > cfg.guardMHz);
+            TEST_ASSERT_TRUE(fabs(lo1 - seg[s].if1MHz) > cfg.guardMHz);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(IfPlanner::pointCount(START, STOP, STEP), next);
+
+    // RF crosses the IF1 passband once and LO1 runs out of range once: two settings, one LO3
+    TEST_ASSERT_EQUAL(3, IfPlanner::retunes(seg, n));
+    TEST_ASSERT_TRUE(seg[0].retuneLO2 && seg[0].retuneLO3);
+}
+
+struct ChainCheck {
+    FakeSynth* lo[3];
+    uint32_t points;
+    double worstIf3Error;
+};
+
+static void checkChain(uint32_t index, double rf, void* ctx) {
+    ChainCheck& c = *(ChainCheck*)ctx;
+    double if1 = fabs(c.lo[0]->freqMHz - rf);
+    double if2 = fabs(c.lo[1]->freqMHz - if1);
+    double if3 = fabs(c.lo[2]->freqMHz - if2);
+    double err = fabs(if3 - cfg.if3MHz);
+    if (err > c.worstIf3Error) c.worstIf3Error = err;
+    TEST_ASSERT_EQUAL_UINT32(c.points++, index);
+}
+
+void test_run_lands_every_point_on_if3(void) {
+    uint8_t n = planner.plan(START, STOP, STEP, seg, 16);
+    FakeSynth lo1, lo2, lo3;
+    ChainCheck c = {{&lo1, &lo2, &lo3}, 0, 0};
+    uint32_t played = planner.run(seg, n, START, STEP, lo1, lo2, lo3, checkChain, &c);
+    TEST_ASSERT_EQUAL_UINT32(IfPlanner::pointCount(START, STOP, STEP), played);
+    TEST_ASSERT_EQUAL_UINT32(played, lo1.tunes);
+    TEST_ASSERT_EQUAL_UINT32(IfPlanner::retunes(seg, n), lo2.tunes + lo3.tunes);
+    TEST_ASSERT_TRUE(c.worstIf3Error < 1e-6);
+}
+
+/*  Baseline, as the old frequency calculator did it: IF1 re-centred at every
+    point so LO1 sits on the Fpfd grid (integer-N), with all three LOs
+    programmed per point. Compared on real drivers: words and relocks.
+ */
+void test_fewer_writes_and_relocks_than_per_point_plan(void) {
+    uint8_t n = planner.plan(START, STOP, STEP, seg, 16);
+    CountingBus b1, b2, b3, n1, n2, n3;
+    MAX2871 p1(66.0, b1, b1), p2(66.0, b2, b2), p3(66.0, b3, b3);
+    MAX2871 q1(66.0, n1, n1), q2(66.0, n2, n2), q3(66.0, n3, n3);
+    MAX2871* all[6] = {&p1, &p2, &p3, &q1, &q2, &q3};
+    for (auto lo : all) lo->begin();
+    CountingBus* buses[6] = {&b1, &b2, &b3, &n1, &n2, &n3};
+    for (auto b : buses) b->words = b->relocks = 0;
+
+    planner.run(seg, n, START, STEP, p1, p2, p3);
+
+    for (uint8_t s = 0; s < n; s++) {
+        for (uint32_t k = 0; k < seg[s].points; k++) {
+            double rf = START + (seg[s].firstPoint + k) * STEP;
+            double lo1 = IfPlanner::lo1For(seg[s], rf);
+            double grid = floor(lo1 / 66.0 + 0.5) * 66.0;               // integer-N LO1
+            double if1 = fabs(grid - rf);
+            q1.setFrequency(grid);
+            q2.setFrequency(seg[s].lo2Side == IfPlanner::HIGH_SIDE ? if1 + cfg.if2MHz : if1 - cfg.if2MHz);
+            q3.setFrequency(seg[s].lo3MHz);
+        }
+    }
+
+    uint32_t plannedWords = b1.words + b2.words + b3.words;
+    uint32_t plannedRelocks = b2.relocks + b3.relocks;
+    uint32_t baseWords = n1.words + n2.words + n3.words;
+    uint32_t baseRelocks = n2.relocks + n3.relocks;
+    TEST_ASSERT_TRUE(plannedRelocks <= IfPlanner::retunes(seg, n));   // at changes only (LO2 960 MHz from 60 is an octave step)
+    TEST_ASSERT_TRUE(plannedRelocks * 10 < baseRelocks);
+    TEST_ASSERT_TRUE(plannedWords < baseWords);
+}
+
+void test_infeasible_sweeps(void) {
+    TEST_ASSERT_EQUAL(0, planner.plan(10.0, 100.0, 1.0, seg, 16));   // high-side LO1 within the guard of IF1, low side out of range
+    TEST_ASSERT_EQUAL(0, planner.plan(START, STOP, STEP, seg, 1));   // needs more than one segment
+    TEST_ASSERT_EQUAL(1, planner.plan(100.0, 100.0, 1.0, seg, 16));  // single point
+    TEST_ASSERT_EQUAL_UINT32(1, seg[0].points);
+}
+
+void runAllTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_segments_cover_the_sweep);
+    RUN_TEST(test_run_lands_every_point_on_if3);
+    RUN_TEST(test_fewer_writes_and_relocks_than_per_point_plan);
+    RUN_TEST(test_infeasible_sweeps);
+    UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    delay(2000);
+    runAllTests();
+}
+void loop() { delay(1000); }
+#else
+int main(void) {
+    runAllTests();
+    return 0;
+}
+#endif
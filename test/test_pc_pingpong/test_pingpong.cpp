@@ -0,0 +1,185 @@
+#ifdef ARDUINO
+  #include <Arduino.h>
+#endif
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include "max2871.h"
+#include "pll_pingpong.h"
+
+// ---- Stand-ins ----
+
+static uint32_t simNow;                 // simulated microseconds
+
+// Scripted lock: an R0 write (VCO autocal) unlocks the chip for 'lockUs'
+class LockScriptBus : public I_MAX2871Transport, public IDelayProvider {
+public:
+    explicit LockScriptBus(uint32_t lockUs) : lockUs(lockUs) {}
+
+    uint32_t lockUs;
+    uint32_t lockedAt = 0;
+    uint32_t relocks = 0;
+
+    void delayMs(uint32_t) override {}
+    bool readMuxout() override { return (int32_t)(simNow - lockedAt) >= 0; }
+    void spiWriteRegister(uint32_t value) override {
+        if ((value & 0x7) == 0) {
+            lockedAt = simNow + lockUs;
+            relocks++;
+        }
+    }
+};
+
+struct Switch {
+    LockScriptBus* bus[2];
+    MAX2871* lo[2];
+    uint8_t last;
+    uint32_t flips;
+    uint32_t unlockedFlips;
+};
+
+static void route(uint8_t chip, void* ctx) {
+    Switch& s = *(Switch*)ctx;
+    if (!s.bus[chip]->readMuxout()) s.unlockedFlips++;
+    s.last = chip;
+    s.flips++;
+}
+
+static const uint32_t TICK_US = 5;
+static const uint16_t POINTS = 100;
+static double points[POINTS];
+
+void setUp(void) {
+    simNow = 0xFFFF0000UL;              // wraps during the sweep
+    for (uint16_t i = 0; i < POINTS; i++) points[i] = 2400.0 + 1.5 * i;
+}
+void tearDown(void) {}
+
+// Ping-pong sweep; returns the time from start to the end of the last dwell
+static uint32_t runPair(uint32_t lockUs, uint32_t dwellUs, PLLPingPong::Stats& stats, Switch& sw) {
+    LockScriptBus busA(lockUs), busB(lockUs);
+    MAX2871 loA(66.0, busA, busA), loB(66.0, busB, busB);
+    loA.begin();
+    loB.begin();
+    sw = Switch{{&busA, &busB}, {&loA, &loB}, 0xFF, 0, 0};
+
+    PLLPingPong pair(loA, loB, route, &sw);
+    uint32_t t0 = simNow;
+    pair.start(points, POINTS, simNow, dwellUs);
+    uint16_t expected = 0;
+    while (pair.running()) {
+        if (pair.tick(simNow)) {
+            TEST_ASSERT_EQUAL_UINT16(expected++, pair.point());
+            TEST_ASSERT_EQUAL_UINT8(pair.activeChip(), sw.last);
+            TEST_ASSERT_TRUE(fabs(sw.lo[sw.last]->fmn2freq() - points[pair.point()]) < 1e-3);
+        }
+        simNow += TICK_US;
+    }
+    TEST_ASSERT_EQUAL_UINT16(POINTS, expected);
+    stats = pair.stats();
+    return simNow - t0;
+}
+
+// One chip: tune, wait for lock, dwell
+static uint32_t runSingle(uint32_t lockUs, uint32_t dwellUs) {
+    LockScriptBus bus(lockUs);
+    MAX2871 lo(66.0, bus, bus);
+    lo.begin();
+    uint32_t t0 = simNow;
+    for (uint16_t i = 0; i < POINTS; i++) {
+        lo.setFrequency(points[i]);
+        while (!lo.isLocked()) simNow += TICK_US;
+        simNow += dwellUs;
+    }
+    return simNow - t0;
+}
+
+static void report(const char* label, uint32_t pairUs, uint32_t singleUs) {
+    char msg[96];
+    snprintf(msg, sizeof(msg), "%s: pair %lu steps/s, one chip %lu steps/s", label,
+             (unsigned long)(POINTS * 1000000ULL / pairUs), (unsigned long)(POINTS * 1000000ULL / singleUs));
+    TEST_MESSAGE(msg);
+}
+
+void test_lock_hidden_behind_dwell(void) {
+    PLLPingPong::Stats stats;
+    Switch sw;
+    uint32_t pairUs = runPair(300, 500, stats, sw);
+    TEST_ASSERT_EQUAL_UINT32(POINTS, stats.steps);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.stalls);
+    TEST_ASSERT_EQUAL_UINT32(0, sw.unlockedFlips);
+    TEST_ASSERT_EQUAL_UINT32(POINTS, sw.flips);
+
+    // First lock, then one dwell per point
+    TEST_ASSERT_TRUE(pairUs <= 300 + POINTS * (500 + TICK_US) + TICK_US);
+    uint32_t singleUs = runSingle(300, 500);
+    TEST_ASSERT_TRUE(singleUs >= POINTS * 800u);
+    TEST_ASSERT_TRUE(pairUs * 3 < singleUs * 2);
+    report("lock 300 us, dwell 500 us", pairUs, singleUs);
+}
+
+void test_slow_lock_stalls_but_still_overlaps(void) {
+    PLLPingPong::Stats stats;
+    Switch sw;
+    uint32_t pairUs = runPair(800, 500, stats, sw);
+    TEST_ASSERT_EQUAL_UINT32(POINTS, stats.steps);
+    TEST_ASSERT_EQUAL_UINT32(POINTS - 2, stats.stalls);     // points 0 and 1 were tuned at start()
+    TEST_ASSERT_TRUE(stats.maxStallUs >= 300 && stats.maxStallUs <= 300 + TICK_US);
+    TEST_ASSERT_EQUAL_UINT32(0, sw.unlockedFlips);
+
+    // A step costs the lock time, not lock + dwell
+    uint32_t singleUs = runSingle(800, 500);
+    TEST_ASSERT_TRUE(pairUs <= 800 + POINTS * (800 + TICK_US));
+    TEST_ASSERT_TRUE(pairUs < singleUs * 2 / 3);
+    report("lock 800 us, dwell 500 us", pairUs, singleUs);
+}
+
+void test_repeat_and_stop(void) {
+    LockScriptBus busA(100), busB(100);
+    MAX2871 loA(66.0, busA, busA), loB(66.0, busB, busB);
+    loA.begin();
+    loB.begin();
+    Switch sw = {{&busA, &busB}, {&loA, &loB}, 0xFF, 0, 0};
+    PLLPingPong pair(loA, loB, route, &sw);
+
+    TEST_ASSERT_FALSE(pair.tick(simNow));                   // not started
+    pair.start(points, 3, simNow, 200, true);
+    TEST_ASSERT_EQUAL_UINT16(PLLPingPong::NONE, pair.point());
+    TEST_ASSERT_FALSE(pair.tick(simNow));                   // chip 0 still locking
+
+    uint16_t seen[8];
+    uint8_t n = 0;
+    while (n < 8) {
+        simNow += TICK_US;
+        if (pair.tick(simNow)) seen[n++] = pair.point();
+    }
+    const uint16_t expected[8] = {0, 1, 2, 0, 1, 2, 0, 1};
+    for (uint8_t i = 0; i < 8; i++) TEST_ASSERT_EQUAL_UINT16(expected[i], seen[i]);
+    TEST_ASSERT_EQUAL_UINT8(1, sw.last);                    // chips alternate: point 1 of pass 3 on chip 1
+    TEST_ASSERT_TRUE(pair.running());
+    pair.stop();
+    simNow += 1000;
+    TEST_ASSERT_FALSE(pair.tick(simNow));
+}
+
+void runAllTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_lock_hidden_behind_dwell);
+    RUN_TEST(test_slow_lock_stalls_but_still_overlaps);
+    RUN_TEST(test_repeat_and_stop);
+    UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    delay(2000);
+    runAllTests();
+}
+void loop() { delay(1000); }
+#else
+int main(void) {
+    runAllTests();
+    return 0;
+}
+#endif
@@ -0,0 +1,135 @@
+#ifdef ARDUINO
+  #include <Arduino.h>
+#endif
+#include <unity.h>
+#include "max2871.h"
+#include "max2871_planner.h"
+#include "mock_hal.h"
+
+static MockHAL hal;
+static MAX2871 lo(66.0, hal, hal);
+static MAX2871RefPlanner planner(lo, 66.0, 60.0);
+
+static uint8_t selected;
+static uint8_t selectCalls;
+static void selectRef(uint8_t ref, void*) {
+    selected = ref;
+    selectCalls++;
+}
+
+void setUp(void) {
+    MAX2871RefPlanner::Plan home;
+    planner.candidate(0, 60.0, home);                   // back on REF_EN1
+    planner.apply(home);
+    lo.begin();
+    hal.writeCount = 0;
+    selectCalls = 0;
+    planner.setReferenceSelect(selectRef, nullptr);
+}
+
+void tearDown(void) {}
+
+void test_prefers_integer_n_reference(void) {
+    TEST_ASSERT_EQUAL(1, planner.setFrequency(3900.0));   // 65 x 60 MHz
+    TEST_ASSERT_EQUAL(1, selected);
+    TEST_ASSERT_EQUAL(1, selectCalls);
+    TEST_ASSERT_EQUAL_UINT32(0, lo.Frac);
+    TEST_ASSERT_EQUAL_FLOAT(60.0, lo.reference());
+    TEST_ASSERT_FLOAT_WITHIN(0.000001, 3900.0, lo.fmn2freq());
+
+    TEST_ASSERT_EQUAL(0, planner.setFrequency(4026.0));   // 61 x 66 MHz
+    TEST_ASSERT_EQUAL(0, selected);
+    TEST_ASSERT_EQUAL(2, selectCalls);
+    TEST_ASSERT_EQUAL_UINT32(0, lo.Frac);
+    TEST_ASSERT_FLOAT_WITHIN(0.000001, 4026.0, lo.fmn2freq());
+}
+
+void test_reference_switch_always_writes_r0(void) {
+    planner.setFrequency(3900.0);
+    TEST_ASSERT_EQUAL_HEX32(lo.Curr.Reg[0], hal.regWrites[hal.writeCount - 1]);
+
+    // Force the 66 MHz solution for the same target: R0 goes out last for the autocal
+    MAX2871RefPlanner::Plan p;
+    planner.candidate(0, 3900.0, p);
+    hal.writeCount = 0;
+    planner.apply(p);
+    TEST_ASSERT_EQUAL(0, selected);
+    TEST_ASSERT_EQUAL_HEX32(lo.Curr.Reg[0], hal.regWrites[hal.writeCount - 1]);
+}
+
+void test_plan_ranking(void) {
+    const double freqs[] = {100.0, 915.0, 1420.0, 2400.0, 3600.0, 5800.0, 433.92, 2437.0};
+    for (int i = 0; i < 8; i++) {
+        MAX2871RefPlanner::Plan best, a, b;
+        planner.plan(freqs[i], best);
+        planner.candidate(0, freqs[i], a);
+        planner.candidate(1, freqs[i], b);
+        const MAX2871RefPlanner::Plan& other = best.ref == 0 ? b : a;
+
+        TEST_ASSERT_TRUE(best.errorHz <= 1000.0f || best.errorHz <= other.errorHz);
+        if (best.errorHz <= 1000.0f && other.errorHz <= 1000.0f) {
+            TEST_ASSERT_TRUE(best.integerN || !other.integerN);
+            if (best.integerN == other.integerN) TEST_ASSERT_TRUE(best.writes <= other.writes);
+        }
+        TEST_ASSERT_TRUE(best.writes >= 1 && best.writes <= 4);
+
+        planner.apply(best);
+        TEST_ASSERT_FLOAT_WITHIN(0.002, freqs[i], lo.fmn2freq());
+    }
+}
+
+void test_write_estimate_matches_transport(void) {
+    const double freqs[] = {1420.0, 1421.0, 710.5, 3900.0, 4026.0};
+    for (int i = 0; i < 5; i++) {
+        MAX2871RefPlanner::Plan p;
+        planner.plan(freqs[i], p);
+        hal.writeCount = 0;
+        planner.apply(p);
+        TEST_ASSERT_EQUAL(p.writes, hal.writeCount);
+    }
+}
+
+void test_reference_too_low_for_n_is_never_used(void) {
+    MAX2871RefPlanner low(lo, 66.0, 12.0);              // 12 MHz: N = 5000 / 12 > 255
+    MAX2871RefPlanner::Plan p;
+    low.candidate(1, 5000.0, p);
+    TEST_ASSERT_FALSE(p.valid);
+    TEST_ASSERT_TRUE(low.plan(5000.0, p));
+    TEST_ASSERT_EQUAL(0, p.ref);
+    TEST_ASSERT_EQUAL(0, low.setFrequency(5000.0));
+    TEST_ASSERT_FLOAT_WITHIN(0.002, 5000.0, lo.fmn2freq());
+
+    TEST_ASSERT_TRUE(low.plan(1500.0, p));              // VCO 3000 / 12 = 250 still fits
+    TEST_ASSERT_TRUE(p.valid);
+
+    MAX2871RefPlanner none(lo, 12.0, 11.0);
+    hal.writeCount = 0;
+    TEST_ASSERT_FALSE(none.plan(5000.0, p));
+    none.apply(p);
+    TEST_ASSERT_EQUAL(0, hal.writeCount);
+    TEST_ASSERT_FALSE(planner.plan(0.0, p));            // out of range: no solver run
+}
+
+void runAllTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_prefers_integer_n_reference);
+    RUN_TEST(test_reference_switch_always_writes_r0);
+    RUN_TEST(test_plan_ranking);
+    RUN_TEST(test_write_estimate_matches_transport);
+    RUN_TEST(test_reference_too_low_for_n_is_never_used);
+    UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    delay(2000);
+    runAllTests();
+}
+void loop() { delay(1000); }
+#else
+int main(void) {
+    runAllTests();
+    return 0;
+}
+#endif
@@ -0,0 +1,350 @@
+#ifdef ARDUINO
+  #include <Arduino.h>
+#endif
+#include <unity.h>
+#include "max2871.h"
+#include "max2871_protocol.h"
+#include "max2871_stream.h"
+#include "mock_hal.h"
+
+#if defined(__linux__) && !defined(ARDUINO)
+  #include <fcntl.h>
+  #include <poll.h>
+  #include <stdlib.h>
+  #include <termios.h>
+  #include <unistd.h>
+  #define HAVE_PTY 1
+#endif
+
+using namespace max2871proto;
+
+// ---- In-memory pipe: the client's reads pump the device side ----
+
+struct Pipe {
+    uint8_t toDevice[MAX_FRAME * 2];
+    size_t toDeviceLen;
+    uint8_t toHost[MAX_FRAME * 2];
+    size_t toHostLen;
+    size_t toHostPos;
+    Parser deviceParser;
+    Handler* handler;
+};
+
+static size_t pipeWrite(const uint8_t* data, size_t len, void* ctx) {
+    Pipe* p = static_cast<Pipe*>(ctx);
+    for (size_t i = 0; i < len; ++i) p->toDevice[p->toDeviceLen++] = data[i];
+    return len;
+}
+
+// Device service loop: parse what the host sent and queue the reply
+static void pipeService(Pipe* p) {
+    for (size_t i = 0; i < p->toDeviceLen; ++i) {
+        if (p->deviceParser.feed(p->toDevice[i]) == Parser::FRAME_READY) {
+            p->toHostLen += p->handler->handle(p->deviceParser.frame(), p->toHost + p->toHostLen,
+                                               sizeof(p->toHost) - p->toHostLen);
+        }
+    }
+    p->toDeviceLen = 0;
+}
+
+static int pipeRead(void* ctx) {
+    Pipe* p = static_cast<Pipe*>(ctx);
+    if (p->toHostPos == p->toHostLen) {
+        p->toHostPos = p->toHostLen = 0;
+        pipeService(p);
+        if (p->toHostLen == 0) return -1;
+    }
+    return p->toHost[p->toHostPos++];
+}
+
+static MockHAL hal;
+static MAX2871 lo(66.0, hal, hal);
+static Handler handler(lo);
+static Pipe memPipe;
+static Client client(pipeWrite, pipeRead, &memPipe);
+
+void setUp(void) {
+    lo.begin();
+    hal.writeCount = 0;
+    memPipe.toDeviceLen = memPipe.toHostLen = memPipe.toHostPos = 0;
+    memPipe.deviceParser.reset();
+    memPipe.handler = &handler;
+    handler.setPointHook(nullptr, nullptr);
+    handler.setStreamTransport(nullptr);
+}
+
+void tearDown(void) {}
+
+// ---- Framing ----
+
+void test_encode_layout_and_crc(void) {
+    uint8_t payload[] = {0x10, 0x20, 0x30, 0x40};
+    uint8_t buf[16];
+    size_t n = encode(buf, sizeof(buf), CMD_TUNE, payload, 4);
+    TEST_ASSERT_EQUAL(8, n);
+    TEST_ASSERT_EQUAL_HEX8(SOF, buf[0]);
+    TEST_ASSERT_EQUAL_HEX8(CMD_TUNE, buf[1]);
+    TEST_ASSERT_EQUAL_HEX8(4, buf[2]);
+    TEST_ASSERT_EQUAL_HEX8(crc8(0, buf + 1, 6), buf[7]);
+    TEST_ASSERT_EQUAL(0, encode(buf, 7, CMD_TUNE, payload, 4));     // does not fit
+}
+
+void test_parser_is_zero_copy_and_resyncs(void) {
+    uint8_t payload[] = {1, 2, 3};
+    uint8_t buf[32];
+    size_t n = encode(buf + 4, sizeof(buf) - 4, CMD_REG_WRITE, payload, 3);
+    buf[0] = 0x00;                  // line noise before the frame
+    buf[1] = SOF;                   // false start with an oversized length
+    buf[2] = CMD_TUNE;
+    buf[3] = 0xFF;
+    Parser parser;
+    Parser::Result r = Parser::NEED_MORE;
+    uint8_t errors = 0;
+    for (size_t i = 0; i < n + 4; ++i) {
+        r = parser.feed(buf[i]);
+        if (r == Parser::FRAME_ERROR) errors++;
+    }
+    TEST_ASSERT_EQUAL(Parser::FRAME_READY, r);
+    TEST_ASSERT_EQUAL(1, errors);
+    TEST_ASSERT_EQUAL(3, parser.frame().len);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(payload, parser.frame().payload, 3);
+
+    // Corrupt the CRC
+    buf[n + 3] ^= 0xFF;
+    for (size_t i = 4; i < n + 4; ++i) r = parser.feed(buf[i]);
+    TEST_ASSERT_EQUAL(Parser::FRAME_ERROR, r);
+}
+
+// ---- Client <-> device over the in-memory pipe ----
+
+void test_tune_matches_direct_call(void) {
+    Client::Reply reply;
+    TEST_ASSERT_TRUE(client.tune(2400.0, reply));
+    TEST_ASSERT_EQUAL(STATUS_OK, reply.status);
+
+    MockHAL ref;
+    MAX2871 direct(66.0, ref, ref);
+    direct.begin();
+    direct.setFrequency(2400.0);
+    TEST_ASSERT_EQUAL_HEX32_ARRAY(direct.Curr.Reg, lo.Curr.Reg, 6);
+}
+
+static uint8_t hookCalls;
+static void countPoints(uint8_t, void*) { hookCalls++; }
+
+void test_tune_list_runs_every_point(void) {
+    const double freqs[] = {100.0, 915.0, 1420.0, 5800.0};
+    hookCalls = 0;
+    handler.setPointHook(countPoints, nullptr);
+    Client::Reply reply;
+    TEST_ASSERT_TRUE(client.tuneList(freqs, 4, reply));
+    TEST_ASSERT_EQUAL(STATUS_OK, reply.status);
+    TEST_ASSERT_EQUAL(4, reply.count);
+    TEST_ASSERT_EQUAL(4, hookCalls);
+    TEST_ASSERT_FLOAT_WITHIN(0.002, 5800.0, lo.fmn2freq());
+}
+
+void test_tune_out_of_range_is_rejected(void) {
+    lo.setFrequency(2400.0);
+    MAX2871::max2871Registers before = lo.Curr;
+    hal.writeCount = 0;
+    Client::Reply reply;
+    TEST_ASSERT_TRUE(client.tune(0.0, reply));                  // would never leave the solver
+    TEST_ASSERT_EQUAL(STATUS_BAD_VALUE, reply.status);
+    TEST_ASSERT_TRUE(client.tune(23.4, reply));
+    TEST_ASSERT_EQUAL(STATUS_BAD_VALUE, reply.status);
+    TEST_ASSERT_TRUE(client.tune(6000.001, reply));
+    TEST_ASSERT_EQUAL(STATUS_BAD_VALUE, reply.status);
+    TEST_ASSERT_EQUAL(0, hal.writeCount);
+    TEST_ASSERT_EQUAL_HEX32_ARRAY(before.Reg, lo.Curr.Reg, 6);
+
+    const double freqs[] = {100.0, 915.0, 7000.0, 1420.0};
+    TEST_ASSERT_TRUE(client.tuneList(freqs, 4, reply));
+    TEST_ASSERT_EQUAL(STATUS_BAD_VALUE, reply.status);
+    TEST_ASSERT_EQUAL(2, reply.count);                          // stopped at the bad point
+    TEST_ASSERT_FLOAT_WITHIN(0.002, 915.0, lo.fmn2freq());
+
+    TEST_ASSERT_TRUE(client.tune(23.5, reply));                 // the limits themselves are fine
+    TEST_ASSERT_EQUAL(STATUS_OK, reply.status);
+    TEST_ASSERT_TRUE(client.tune(6000.0, reply));
+    TEST_ASSERT_EQUAL(STATUS_OK, reply.status);
+}
+
+void test_tune_fmn_and_status_round_trip(void) {
+    uint32_t fmn = (744UL << 20) | (4092UL << 8) | 58UL;
+    uint8_t diva = 6;
+    Client::Reply reply;
+    TEST_ASSERT_TRUE(client.tuneFMN(&fmn, &diva, 1, reply));
+    TEST_ASSERT_EQUAL(STATUS_OK, reply.status);
+
+    TEST_ASSERT_TRUE(client.status(reply));
+    TEST_ASSERT_EQUAL(STATUS_OK, reply.status);
+    TEST_ASSERT_FALSE(reply.locked);                // MockHAL MUXOUT is low
+    TEST_ASSERT_EQUAL_HEX32(fmn, reply.fmn);
+    TEST_ASSERT_EQUAL(diva, reply.diva);
+}
+
+void test_register_poke(void) {
+    uint32_t words[] = {0x80005F42 | (1UL << 5), 0x00000006};   // R2 shutdown, then R6 (read-only)
+    Client::Reply reply;
+    TEST_ASSERT_TRUE(client.writeRegisters(words, 2, reply));
+    TEST_ASSERT_EQUAL(STATUS_BAD_VALUE, reply.status);
+    TEST_ASSERT_EQUAL(1, reply.count);
+    TEST_ASSERT_EQUAL_HEX32(words[0], lo.Curr.Reg[2]);
+    TEST_ASSERT_EQUAL_HEX32(words[0], hal.regWrites[0]);
+}
+
+void test_register_poke_updates_status(void) {
+    Client::Reply reply;
+    TEST_ASSERT_TRUE(client.tune(1000.0, reply));
+    TEST_ASSERT_EQUAL(2, lo.DIVA);
+    uint32_t words[] = {lo.Curr.Reg[4] & ~(0x7UL << 20),                // DIVA = 0
+                        (lo.Curr.Reg[0] & ~(0xFFFFUL << 15)) | (80UL << 15)};  // N = 80
+    TEST_ASSERT_TRUE(client.writeRegisters(words, 2, reply));
+    TEST_ASSERT_EQUAL(STATUS_OK, reply.status);
+
+    TEST_ASSERT_TRUE(client.status(reply));
+    TEST_ASSERT_EQUAL(0, reply.diva);
+    TEST_ASSERT_EQUAL_UINT32(80, reply.fmn & 0xFF);
+}
+
+void test_unknown_command_is_rejected(void) {
+    Frame f = {0x7E, 0, nullptr};
+    uint8_t reply[8];
+    size_t n = handler.handle(f, reply, sizeof(reply));
+    TEST_ASSERT_EQUAL(5, n);
+    TEST_ASSERT_EQUAL_HEX8(0x7E | REPLY, reply[1]);
+    TEST_ASSERT_EQUAL(STATUS_BAD_COMMAND, reply[3]);
+}
+
+void test_stream_plays_host_encoded_sweep(void) {
+    // The host runs its own driver and records what each point writes
+    MockHAL hostHal;
+    MAX2871 hostLo(66.0, hostHal, hostHal);
+    hostLo.begin();
+    hostLo.setFrequency(2400.0);
+    uint8_t buf[256];
+    max2871stream::Encoder enc(buf, sizeof(buf));
+    TEST_ASSERT_TRUE(enc.keyframe(hostLo.Curr.Reg));
+    for (int i = 1; i <= 40; i++) {
+        hostHal.writeCount = 0;
+        hostLo.setFrequency(2400.0 + 0.25 * i);
+        TEST_ASSERT_TRUE(enc.point(hostHal.regWrites, hostHal.writeCount));
+    }
+    TEST_ASSERT_TRUE(enc.finish());
+
+    Client::Reply reply;
+    TEST_ASSERT_TRUE(client.stream(buf, enc.size(), reply));
+    TEST_ASSERT_EQUAL(STATUS_BAD_COMMAND, reply.status);    // no stream transport yet
+
+    handler.setStreamTransport(&hal);
+    TEST_ASSERT_TRUE(client.stream(buf, enc.size(), reply));
+    TEST_ASSERT_EQUAL(STATUS_OK, reply.status);
+    TEST_ASSERT_EQUAL(41, reply.count);
+    TEST_ASSERT_EQUAL_HEX32_ARRAY(hostLo.Curr.Reg, lo.Curr.Reg, 6);
+    TEST_ASSERT_FLOAT_WITHIN(0.002, 2410.0, lo.fmn2freq());  // driver is back in step
+
+    hal.writeCount = 0;
+    lo.setFrequency(2410.0);                                // nothing left to write
+    TEST_ASSERT_EQUAL(0, hal.writeCount);
+}
+
+void test_stream_reports_rejected_image(void) {
+    // A shadow the driver cannot adopt: R3 carries the wrong address
+    handler.setStreamTransport(&hal);
+    lo.Curr.Reg[3] = (lo.Curr.Reg[3] & ~0x7UL) | 0x6;
+    uint8_t rec[5] = {(uint8_t)(max2871stream::TAG_ABSOLUTE | 0x01)};
+    putU32(rec + 1, lo.Curr.Reg[0]);
+
+    Client::Reply reply;
+    TEST_ASSERT_TRUE(client.stream(rec, sizeof(rec), reply));
+    TEST_ASSERT_EQUAL(STATUS_BAD_VALUE, reply.status);
+    TEST_ASSERT_EQUAL(1, reply.count);
+}
+
+// ---- Client <-> device over a pseudo-terminal ----
+#ifdef HAVE_PTY
+struct PtyLink {
+    int host;
+    int dev;
+    Parser deviceParser;
+};
+
+static size_t ptyWrite(const uint8_t* data, size_t len, void* ctx) {
+    PtyLink* l = static_cast<PtyLink*>(ctx);
+    return (size_t)write(l->host, data, len);
+}
+
+static int ptyRead(void* ctx) {
+    PtyLink* l = static_cast<PtyLink*>(ctx);
+    // Service the device end, then read one reply byte from the host end
+    uint8_t c;
+    struct pollfd pfd = {l->dev, POLLIN, 0};
+    while (poll(&pfd, 1, 0) > 0 && read(l->dev, &c, 1) == 1) {
+        if (l->deviceParser.feed(c) == Parser::FRAME_READY) {
+            uint8_t reply[MAX_FRAME];
+            size_t n = handler.handle(l->deviceParser.frame(), reply, sizeof(reply));
+            if (write(l->dev, reply, n) != (ssize_t)n) return -1;
+        }
+    }
+    struct pollfd hfd = {l->host, POLLIN, 0};
+    if (poll(&hfd, 1, 200) <= 0 || read(l->host, &c, 1) != 1) return -1;
+    return c;
+}
+
+void test_client_over_pty(void) {
+    PtyLink link;
+    link.host = posix_openpt(O_RDWR | O_NOCTTY);
+    TEST_ASSERT_TRUE(link.host >= 0);
+    TEST_ASSERT_EQUAL(0, grantpt(link.host));
+    TEST_ASSERT_EQUAL(0, unlockpt(link.host));
+    link.dev = open(ptsname(link.host), O_RDWR | O_NOCTTY);
+    TEST_ASSERT_TRUE(link.dev >= 0);
+    struct termios t;
+    tcgetattr(link.dev, &t);
+    cfmakeraw(&t);
+    tcsetattr(link.dev, TCSANOW, &t);
+
+    Client ptyClient(ptyWrite, ptyRead, &link);
+    Client::Reply reply;
+    bool ok = ptyClient.tune(1420.0, reply);
+    close(link.dev);
+    close(link.host);
+    TEST_ASSERT_TRUE(ok);
+    TEST_ASSERT_EQUAL(STATUS_OK, reply.status);
+    TEST_ASSERT_FLOAT_WITHIN(0.002, 1420.0, lo.fmn2freq());
+}
+#endif
+
+void runAllTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_encode_layout_and_crc);
+    RUN_TEST(test_parser_is_zero_copy_and_resyncs);
+    RUN_TEST(test_tune_matches_direct_call);
+    RUN_TEST(test_tune_list_runs_every_point);
+    RUN_TEST(test_tune_out_of_range_is_rejected);
+    RUN_TEST(test_tune_fmn_and_status_round_trip);
+    RUN_TEST(test_register_poke);
+    RUN_TEST(test_register_poke_updates_status);
+    RUN_TEST(test_unknown_command_is_rejected);
+    RUN_TEST(test_stream_plays_host_encoded_sweep);
+    RUN_TEST(test_stream_reports_rejected_image);
+#ifdef HAVE_PTY
+    RUN_TEST(test_client_over_pty);
+#endif
+    UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    delay(2000);
+    runAllTests();
+}
+void loop() { delay(1000); }
+#else
+int main(void) {
+    runAllTests();
+    return 0;
+}
+#endif
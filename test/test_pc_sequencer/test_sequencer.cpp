@@ -0,0 +1,282 @@
+#ifdef ARDUINO
+  #include <Arduino.h>
+#endif
+#include <unity.h>
+#include "max2871.h"
+#include "mcu_hal.h"
+#include "max2871_transport.h"
+
+// ---- Device model ----
+// Tracks what the synthesizer actually runs on, as opposed to what was shifted in.
+// R1 M/P are double-buffered until R0, as are R4 DIVA/BS when R2 REG4DB is set.
+// Fpfd (R2) and VCO selection (R3) changes only take effect through the R0 autocal.
+
+static const uint32_t DB1   = 0x07FFFFF8;   // R1 M, P
+static const uint32_t DB4   = 0x037FF000;   // R4 BS, DIVA
+static const uint32_t FPFD2 = 0x03FFC000;   // R2 DBR, RDIV2, R
+static const uint32_t VCO3  = 0xFE000000;   // R3 VCO, VAS_SHDN
+
+class ChipModel : public IDelayProvider, public I_MAX2871Transport {
+public:
+    uint32_t input[6];
+    uint32_t active[6];
+    bool autocalNeeded = false;
+    uint16_t redundant = 0;             // words that changed nothing
+    uint8_t traceLen = 0;
+    uint8_t trace[16];                  // register addresses in write order
+
+    void delayMs(uint32_t) override {}
+    bool readMuxout() override { return true; }
+
+    void clearTrace() { traceLen = 0; redundant = 0; }
+
+    void spiWriteRegister(uint32_t w) override {
+        uint8_t reg = w & 0x7;
+        bool changed = input[reg] != w;
+        input[reg] = w;
+        if (traceLen < sizeof(trace)) trace[traceLen++] = reg;
+
+        bool reg4db = (active[2] >> 13) & 1;
+        switch (reg) {
+            case 0: {
+                // R4 only differs from active[] if it went in while REG4DB was set
+                bool latchPending = ((input[1] ^ active[1]) & DB1) ||
+                                    ((input[4] ^ active[4]) & DB4);
+                if (!changed && !latchPending && !autocalNeeded) redundant++;
+                active[0] = w;
+                active[1] = input[1];
+                active[4] = input[4];
+                autocalNeeded = false;
+                return;
+            }
+            case 1:
+                active[1] = (active[1] & DB1) | (w & ~DB1);
+                break;
+            case 2:
+                if ((active[2] ^ w) & FPFD2) autocalNeeded = true;
+                active[2] = w;
+                break;
+            case 3:
+                if ((active[3] ^ w) & VCO3) autocalNeeded = true;
+                active[3] = w;
+                break;
+            case 4:
+                active[4] = reg4db ? (active[4] & DB4) | (w & ~DB4) : w;
+                break;
+            default:
+                active[reg] = w;
+                break;
+        }
+        if (!changed) redundant++;
+    }
+};
+
+static ChipModel chip;
+static MAX2871 lo(66.0, chip, chip);
+
+static void assertChipMatchesShadow() {
+    TEST_ASSERT_EQUAL_HEX32_ARRAY(lo.Curr.Reg, chip.active, 6);
+    TEST_ASSERT_FALSE(chip.autocalNeeded);
+    TEST_ASSERT_EQUAL(0, chip.redundant);
+}
+
+void setUp(void) {
+    lo.begin();
+    chip.clearTrace();
+}
+
+void tearDown(void) {}
+
+// ---- Golden traces ----
+
+void test_output_power_is_one_word(void) {
+    lo.outputPower(+2, RF_ALL);
+    TEST_ASSERT_EQUAL(1, chip.traceLen);
+    TEST_ASSERT_EQUAL(4, chip.trace[0]);
+    lo.outputSelect(RF_A);
+    TEST_ASSERT_EQUAL(2, chip.traceLen);
+    assertChipMatchesShadow();
+}
+
+void test_m_change_commits_through_r0(void) {
+    lo.setFrequency(2400.0);
+    chip.clearTrace();
+    lo.setFrequency(1420.0);
+    TEST_ASSERT_TRUE(chip.traceLen >= 2);
+    TEST_ASSERT_EQUAL(0, chip.trace[chip.traceLen - 1]);    // R0 always last
+    assertChipMatchesShadow();
+}
+
+void test_diva_only_change_with_reg4db(void) {
+    lo.setRegister(lo.Curr.Reg[2] | (1UL << 13));            // REG4DB on
+    lo.setFrequency(1000.0);
+    chip.clearTrace();
+    lo.setFrequency(2000.0);                                 // same VCO, DIVA 2 -> 1
+    TEST_ASSERT_EQUAL(2, chip.traceLen);
+    TEST_ASSERT_EQUAL(4, chip.trace[0]);
+    TEST_ASSERT_EQUAL(0, chip.trace[1]);
+    assertChipMatchesShadow();
+
+    lo.setRegister(lo.Curr.Reg[2] & ~(1UL << 13));           // REG4DB off: R4 alone
+    lo.setFrequency(1000.0);
+    chip.clearTrace();
+    lo.setFrequency(2000.0);
+    TEST_ASSERT_EQUAL(1, chip.traceLen);
+    TEST_ASSERT_EQUAL(4, chip.trace[0]);
+    assertChipMatchesShadow();
+}
+
+void test_reg4db_cleared_with_diva_in_one_pass(void) {
+    lo.setRegister(lo.Curr.Reg[2] | (1UL << 13));            // REG4DB on
+    lo.setFrequency(1000.0);
+    chip.clearTrace();
+    lo.Curr.Reg[2] &= ~(1UL << 13);                          // REG4DB off and DIVA 2 -> 1
+    lo.Curr.Reg[4] = (lo.Curr.Reg[4] & ~(7UL << 20)) | (1UL << 20);
+    lo.setRegister(lo.Curr.Reg[4]);                          // one pass for both
+    TEST_ASSERT_EQUAL(3, chip.traceLen);
+    TEST_ASSERT_EQUAL(4, chip.trace[0]);                     // taken while REG4DB still set
+    TEST_ASSERT_EQUAL(2, chip.trace[1]);
+    TEST_ASSERT_EQUAL(0, chip.trace[2]);                     // so R0 must follow
+    assertChipMatchesShadow();
+
+    chip.clearTrace();
+    lo.Curr.Reg[2] |= 1UL << 13;                             // REG4DB on and DIVA 1 -> 2
+    lo.Curr.Reg[4] = (lo.Curr.Reg[4] & ~(7UL << 20)) | (2UL << 20);
+    lo.setRegister(lo.Curr.Reg[4]);
+    TEST_ASSERT_EQUAL(2, chip.traceLen);                     // R4 applies at once: no R0
+    TEST_ASSERT_EQUAL(4, chip.trace[0]);
+    TEST_ASSERT_EQUAL(2, chip.trace[1]);
+    assertChipMatchesShadow();
+    lo.setRegister(lo.Curr.Reg[2] & ~(1UL << 13));
+}
+
+void test_reference_divider_change_reruns_autocal(void) {
+    lo.setRegister((lo.Curr.Reg[2] & ~FPFD2) | (2UL << 14));  // R = 2
+    TEST_ASSERT_EQUAL(2, chip.traceLen);
+    TEST_ASSERT_EQUAL(2, chip.trace[0]);
+    TEST_ASSERT_EQUAL(0, chip.trace[1]);
+    assertChipMatchesShadow();
+}
+
+void test_standby_wake_trace(void) {
+    lo.outputPower(+5, RF_A);                                // already the default: no write
+    TEST_ASSERT_EQUAL(0, chip.traceLen);
+    lo.standby();
+    lo.wake();
+    TEST_ASSERT_EQUAL(3, chip.traceLen);                     // R2, then R2 + R0
+    TEST_ASSERT_EQUAL_HEX32_ARRAY(lo.Curr.Reg, chip.active, 6);
+}
+
+// ---- Stage / latch ----
+
+static void assertStageIsInvisible(double freqMHz) {
+    uint32_t before[6];
+    for (uint8_t r = 0; r < 6; r++) before[r] = chip.active[r];
+    chip.clearTrace();
+    lo.stageFrequency(freqMHz);
+    TEST_ASSERT_EQUAL_HEX32_ARRAY(before, chip.active, 6);   // still running the old point
+    TEST_ASSERT_FALSE(chip.autocalNeeded);
+    for (uint8_t k = 0; k < chip.traceLen; k++) TEST_ASSERT_NOT_EQUAL(0, chip.trace[k]);
+}
+
+void test_stage_then_latch_is_one_word(void) {
+    lo.setDoubleBuffer(true);
+    lo.setFrequency(1000.3);
+    assertStageIsInvisible(2002.1);                          // new M, N, F and DIVA
+    TEST_ASSERT_EQUAL(2, chip.traceLen);                     // R4 and R1 buffers
+    TEST_ASSERT_TRUE(lo.isStaged());
+    chip.clearTrace();
+    lo.latch();
+    TEST_ASSERT_EQUAL(1, chip.traceLen);
+    TEST_ASSERT_EQUAL(0, chip.trace[0]);
+    TEST_ASSERT_FALSE(lo.isStaged());
+    assertChipMatchesShadow();
+    TEST_ASSERT_FLOAT_WITHIN(0.002, 2002.1, lo.fmn2freq());
+
+    lo.setDoubleBuffer(false);                               // DIVA now waits for the latch
+    assertStageIsInvisible(1000.3);
+    chip.clearTrace();
+    lo.latch();
+    TEST_ASSERT_EQUAL(2, chip.traceLen);                     // R4, R0
+    assertChipMatchesShadow();
+}
+
+// ---- Random operation sequences against the model ----
+
+static uint32_t rng = 12345;
+static uint32_t nextRandom() {
+    rng = rng * 1103515245UL + 12345UL;
+    return rng >> 8;
+}
+
+void test_random_sequences_stay_consistent_and_minimal(void) {
+    const int8_t powers[] = {-4, -1, 2, 5};
+    const RFOutPort ports[] = {RFNONE, RF_A, RF_B, RF_ALL};
+#ifdef ARDUINO
+    const int steps = 200;
+#else
+    const int steps = 3000;
+#endif
+    for (int i = 0; i < steps; i++) {
+        chip.clearTrace();
+        switch (nextRandom() % 9) {
+            case 0:
+            case 1:
+                lo.setFrequency(23.5 + (nextRandom() % 59765) / 10.0);
+                break;
+            case 2:
+                lo.outputPower(powers[nextRandom() % 4], ports[nextRandom() % 4]);
+                break;
+            case 3:
+                lo.outputSelect(ports[nextRandom() % 4]);
+                break;
+            case 4:
+                lo.setRegister(lo.Curr.Reg[2] ^ (1UL << 13));   // toggle REG4DB
+                break;
+            case 5:
+                lo.setRegister((lo.Curr.Reg[3] & ~VCO3) | ((nextRandom() % 64) << 26));
+                break;
+            case 6:
+                lo.setMuteUntilLock(nextRandom() & 1);
+                break;
+            case 7:
+                lo.setFrequency(nextRandom() & 0x0FFFFFFF, nextRandom() % 8);
+                break;
+            case 8:
+                assertStageIsInvisible(23.5 + (nextRandom() % 59765) / 10.0);
+                lo.latch();
+                break;
+        }
+        assertChipMatchesShadow();
+        if (chip.traceLen > 0 && chip.trace[chip.traceLen - 1] != 0) {
+            for (uint8_t k = 0; k < chip.traceLen; k++) TEST_ASSERT_NOT_EQUAL(0, chip.trace[k]);
+        }
+    }
+}
+
+void runAllTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_output_power_is_one_word);
+    RUN_TEST(test_m_change_commits_through_r0);
+    RUN_TEST(test_diva_only_change_with_reg4db);
+    RUN_TEST(test_reg4db_cleared_with_diva_in_one_pass);
+    RUN_TEST(test_reference_divider_change_reruns_autocal);
+    RUN_TEST(test_standby_wake_trace);
+    RUN_TEST(test_stage_then_latch_is_one_word);
+    RUN_TEST(test_random_sequences_stay_consistent_and_minimal);
+    UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    delay(2000);
+    runAllTests();
+}
+void loop() { delay(1000); }
+#else
+int main(void) {
+    runAllTests();
+    return 0;
+}
+#endif
@@ -0,0 +1,205 @@
+#ifdef ARDUINO
+  #include <Arduino.h>
+#endif
+#include <unity.h>
+#include "max2871.h"
+#include "spi_bus.h"
+#include "mcu_hal.h"
+
+// ---- Recording port: every bus event, in order ----
+
+struct Event {
+    char kind;                          // 'B'egin, 'T'ransfer, 'E'nd, 'P'in
+    uint32_t a;                         // clock / first tx byte / pin
+    uint8_t b;                          // mode / length / level
+};
+
+class RecordingPort : public I_SpiPort {
+public:
+    Event events[128];
+    uint8_t count = 0;
+    uint8_t misoByte = 0x5A;
+    uint32_t lastWords[16];             // transfers of 4 bytes, as MSB-first words
+    uint8_t wordCount = 0;
+
+    void clear() { count = 0; wordCount = 0; }
+
+    void beginSession(uint32_t clockHz, uint8_t mode) override { add('B', clockHz, mode); }
+    void endSession() override { add('E', 0, 0); }
+    void writePin(uint8_t pin, bool high) override { add('P', pin, high ? 1 : 0); }
+    bool readPin(uint8_t) override { return true; }
+
+    void transfer(const uint8_t* tx, uint8_t* rx, uint8_t len) override {
+        add('T', tx[0], len);
+        for (uint8_t i = 0; i < len; i++) {
+            if (rx) rx[i] = misoByte + i;
+        }
+        if (len == 4 && wordCount < 16) {
+            lastWords[wordCount++] = ((uint32_t)tx[0] << 24) | ((uint32_t)tx[1] << 16) |
+                                     ((uint32_t)tx[2] << 8) | tx[3];
+        }
+    }
+
+    uint8_t countOf(char kind) const {
+        uint8_t n = 0;
+        for (uint8_t i = 0; i < count; i++) n += events[i].kind == kind;
+        return n;
+    }
+
+private:
+    void add(char kind, uint32_t a, uint8_t b) {
+        if (count < 128) events[count++] = {kind, a, b};
+    }
+};
+
+class NoDelay : public IDelayProvider {
+public:
+    void delayMs(uint32_t) override {}
+};
+
+// Pins as on the SpecAnn board
+static const uint8_t SEL_LO1 = 17, SEL_LO2 = 3, SEL_ATTEN = 19, SEL_ADC = 10;
+
+static RecordingPort port;
+static SpiBusManager* bus;
+static uint8_t lo1, lo2, att, adc;
+
+void setUp(void) {
+    static SpiBusManager* made = nullptr;
+    if (!made) {
+        made = new SpiBusManager(port);
+        lo1 = made->addDevice({20000000UL, 0, SEL_LO1, SPI_SELECT_LATCH, 2});
+        lo2 = made->addDevice({20000000UL, 0, SEL_LO2, SPI_SELECT_LATCH, 2});
+        att = made->addDevice({10000000UL, 0, SEL_ATTEN, SPI_SELECT_LATCH, 1});
+        adc = made->addDevice({4000000UL, 1, SEL_ADC, SPI_SELECT_ACTIVE_LOW, 0});
+    }
+    bus = made;
+    bus->flush();
+    port.clear();
+}
+
+void tearDown(void) {}
+
+static uint8_t transferIndex(uint8_t n) {      // event index of the n-th transfer
+    for (uint8_t i = 0; i < port.count; i++) {
+        if (port.events[i].kind == 'T' && n-- == 0) return i;
+    }
+    return 0xFF;
+}
+
+void test_priority_order_keeps_device_order(void) {
+    const uint8_t a[1] = {0xA0}, d[2] = {0xD0, 0x00}, w1[4] = {0x11, 0, 0, 0}, w2[4] = {0x12, 0, 0, 0};
+    TEST_ASSERT_TRUE(bus->submit(adc, d, 2));
+    TEST_ASSERT_TRUE(bus->submit(lo1, w1, 4));
+    TEST_ASSERT_TRUE(bus->submit(att, a, 1));
+    TEST_ASSERT_TRUE(bus->submit(lo1, w2, 4));
+    TEST_ASSERT_EQUAL(4, bus->flush());
+
+    const uint8_t order[4] = {0x11, 0x12, 0xA0, 0xD0};
+    for (uint8_t i = 0; i < 4; i++) TEST_ASSERT_EQUAL_HEX8(order[i], port.events[transferIndex(i)].a);
+}
+
+void test_same_settings_share_a_session(void) {
+    const uint8_t w[4] = {0, 0, 0, 5};
+    for (uint8_t i = 0; i < 3; i++) bus->submit(lo1, w, 4);
+    for (uint8_t i = 0; i < 3; i++) bus->submit(lo2, w, 4);
+    uint32_t before = bus->sessions();
+    bus->flush();
+    TEST_ASSERT_EQUAL(1, bus->sessions() - before);    // six words, both LOs, one session
+    TEST_ASSERT_EQUAL(1, port.countOf('B'));
+    TEST_ASSERT_EQUAL(1, port.countOf('E'));
+    TEST_ASSERT_EQUAL_UINT32(20000000UL, port.events[0].a);
+
+    port.clear();
+    const uint8_t a[1] = {0x3F}, d[2] = {0, 0};
+    bus->submit(lo1, w, 4);
+    bus->submit(att, a, 1);
+    bus->submit(adc, d, 2);
+    bus->flush();
+    TEST_ASSERT_EQUAL(3, port.countOf('B'));           // each device's own clock and mode
+    TEST_ASSERT_EQUAL(1, port.events[transferIndex(2) - 2].b);     // ADC session runs mode 1
+}
+
+void test_select_styles(void) {
+    const uint8_t w[4] = {1, 2, 3, 4}, d[2] = {0x80, 0x00};
+    uint8_t rx[2] = {0, 0};
+    bus->submit(lo1, w, 4);
+    bus->submit(adc, d, 2, rx);
+    bus->flush();
+
+    uint8_t t = transferIndex(0);                       // LE: data, then high, then low
+    TEST_ASSERT_EQUAL('P', port.events[t + 1].kind);
+    TEST_ASSERT_EQUAL(SEL_LO1, port.events[t + 1].a);
+    TEST_ASSERT_EQUAL(1, port.events[t + 1].b);
+    TEST_ASSERT_EQUAL(0, port.events[t + 2].b);
+
+    t = transferIndex(1);                               // CS: low around the data
+    TEST_ASSERT_EQUAL(SEL_ADC, port.events[t - 1].a);
+    TEST_ASSERT_EQUAL(0, port.events[t - 1].b);
+    TEST_ASSERT_EQUAL(1, port.events[t + 1].b);
+    TEST_ASSERT_EQUAL_HEX8(0x5A, rx[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x5B, rx[1]);
+}
+
+void test_max2871_over_shared_bus(void) {
+    NoDelay timing;
+    SpiBusTransport lo1Bus(*bus, lo1, 14);
+    MAX2871 lo(66.0, lo1Bus, timing);
+    lo.begin();
+    port.clear();
+
+    const uint8_t d[2] = {0, 0};
+    bus->submit(adc, d, 2);                             // pending ADC read rides along
+    uint32_t before = bus->sessions();
+    lo.setFrequency(2400.0);
+    TEST_ASSERT_EQUAL(0, bus->queued());
+    TEST_ASSERT_EQUAL(2, bus->sessions() - before);     // LO words together, then the ADC
+    TEST_ASSERT_TRUE(port.wordCount >= 1);
+    TEST_ASSERT_EQUAL_HEX32(lo.Curr.Reg[0], port.lastWords[port.wordCount - 1]);
+    TEST_ASSERT_TRUE(transferIndex(port.wordCount) > transferIndex(port.wordCount - 1));
+    TEST_ASSERT_TRUE(lo.isLocked());
+    TEST_ASSERT_EQUAL_UINT32(0, lo1Bus.errors());
+}
+
+void test_refused_words_are_counted(void) {
+    SpiBusTransport stray(*bus, 7);                     // never registered
+    const uint32_t words[3] = {0x00400005UL, 0x63BE80E4UL, 0x00000003UL};
+    stray.spiWriteRegisters(words, 3);
+    TEST_ASSERT_EQUAL_UINT32(3, stray.errors());
+    TEST_ASSERT_EQUAL(0, port.countOf('T'));
+}
+
+void test_bad_submissions_and_full_queue(void) {
+    const uint8_t w[4] = {0, 0, 0, 0};
+    TEST_ASSERT_FALSE(bus->submit(7, w, 4));
+    TEST_ASSERT_FALSE(bus->submit(lo1, w, 0));
+    TEST_ASSERT_FALSE(bus->submit(lo1, w, SPI_BUS_MAX_BYTES + 1));
+    for (uint8_t i = 0; i < SPI_BUS_QUEUE + 1; i++) TEST_ASSERT_TRUE(bus->submit(lo1, w, 4));
+    TEST_ASSERT_EQUAL(1, bus->queued());                // the full queue went out first
+    TEST_ASSERT_EQUAL(SPI_BUS_QUEUE, port.countOf('T'));
+}
+
+void runAllTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_priority_order_keeps_device_order);
+    RUN_TEST(test_same_settings_share_a_session);
+    RUN_TEST(test_select_styles);
+    RUN_TEST(test_max2871_over_shared_bus);
+    RUN_TEST(test_refused_words_are_counted);
+    RUN_TEST(test_bad_submissions_and_full_queue);
+    UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    delay(2000);
+    runAllTests();
+}
+void loop() { delay(1000); }
+#else
+int main(void) {
+    runAllTests();
+    return 0;
+}
+#endif
@@ -0,0 +1,201 @@
+#ifdef ARDUINO
+  #include <Arduino.h>
+#endif
+#include <unity.h>
+#include "max2871.h"
+#include "linux_spidev_hal.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+#if defined(__linux__) && !defined(ARDUINO)
+
+// ---- Fake kernel: records what the HAL asks for ----
+
+static const int SPI_FD = 10;
+static const int CHIP_FD = 20;
+static const int LINE_FD_BASE = 100;
+
+struct FakeKernel {
+    int opens;
+    int closes;
+    int messages;                       // SPI_IOC_MESSAGE calls
+    int lastCount;                      // transfers in the last message
+    uint8_t lastCsChange[LinuxSpidevHAL::MAX_BATCH];
+    uint32_t words[32];                 // every word sent, decoded from the tx bytes
+    int wordCount;
+    uint32_t speedHz;
+    uint8_t mode;
+    uint64_t lineFlags[64];
+    uint8_t muxLevel;
+    uint8_t ceLevel;
+};
+
+static FakeKernel k;
+
+static int fakeOpen(const char* path, int) {
+    k.opens++;
+    return strstr(path, "gpiochip") ? CHIP_FD : SPI_FD;
+}
+
+static int fakeClose(int) {
+    k.closes++;
+    return 0;
+}
+
+static int fakeIoctl(int fd, unsigned long request, void* arg) {
+    if (fd == SPI_FD && _IOC_TYPE(request) == SPI_IOC_MAGIC && _IOC_NR(request) == 0) {
+        int n = _IOC_SIZE(request) / sizeof(struct spi_ioc_transfer);
+        struct spi_ioc_transfer* x = static_cast<struct spi_ioc_transfer*>(arg);
+        k.messages++;
+        k.lastCount = n;
+        for (int i = 0; i < n; i++) {
+            const uint8_t* b = (const uint8_t*)(uintptr_t)x[i].tx_buf;
+            k.words[k.wordCount++ % 32] = ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) |
+                                          ((uint32_t)b[2] << 8) | b[3];
+            k.lastCsChange[i] = x[i].cs_change;
+            k.speedHz = x[i].speed_hz;
+        }
+        return 0;
+    }
+    if (request == SPI_IOC_WR_MODE) { k.mode = *(uint8_t*)arg; return 0; }
+    if (request == SPI_IOC_WR_MAX_SPEED_HZ) { k.speedHz = *(uint32_t*)arg; return 0; }
+    if (request == SPI_IOC_WR_BITS_PER_WORD || request == SPI_IOC_WR_LSB_FIRST) return 0;
+    if (fd == CHIP_FD && request == GPIO_V2_GET_LINE_IOCTL) {
+        struct gpio_v2_line_request* req = static_cast<struct gpio_v2_line_request*>(arg);
+        k.lineFlags[req->offsets[0]] = req->config.flags;
+        req->fd = LINE_FD_BASE + req->offsets[0];
+        return 0;
+    }
+    if (request == GPIO_V2_LINE_GET_VALUES_IOCTL) {
+        static_cast<struct gpio_v2_line_values*>(arg)->bits = k.muxLevel;
+        return 0;
+    }
+    if (request == GPIO_V2_LINE_SET_VALUES_IOCTL) {
+        k.ceLevel = static_cast<struct gpio_v2_line_values*>(arg)->bits & 1;
+        return 0;
+    }
+    return -1;
+}
+
+static const LinuxSysOps fakeOps = {fakeOpen, fakeClose, fakeIoctl};
+
+static void resetKernel() { memset(&k, 0, sizeof(k)); }
+
+// ---- Tests ----
+
+void test_begin_configures_spi_and_lines(void) {
+    resetKernel();
+    LinuxSpidevHAL hal(fakeOps);
+    TEST_ASSERT_TRUE(hal.begin("/dev/spidev0.0", 10000000UL, "/dev/gpiochip0", 25, 24));
+    TEST_ASSERT_EQUAL(SPI_MODE_0, k.mode);
+    TEST_ASSERT_EQUAL_UINT32(10000000UL, k.speedHz);
+    TEST_ASSERT_TRUE(k.lineFlags[25] & GPIO_V2_LINE_FLAG_OUTPUT);
+    TEST_ASSERT_TRUE(k.lineFlags[24] & GPIO_V2_LINE_FLAG_INPUT);
+    TEST_ASSERT_EQUAL(1, k.closes);                     // gpiochip fd released after the requests
+
+    k.muxLevel = 1;
+    TEST_ASSERT_TRUE(hal.readMuxout());
+    hal.setCEPin(true);
+    TEST_ASSERT_EQUAL(1, k.ceLevel);
+    hal.end();
+    TEST_ASSERT_EQUAL(4, k.closes);
+    TEST_ASSERT_EQUAL(0, hal.errors());
+}
+
+void test_one_message_per_update(void) {
+    resetKernel();
+    LinuxSpidevHAL hal(fakeOps);
+    hal.attach(SPI_FD);
+    MAX2871 lo(66.0, hal, hal);
+    lo.begin();
+    TEST_ASSERT_EQUAL(3, k.messages);                   // R5, 20 ms, R4..R0, all six again
+    TEST_ASSERT_EQUAL(6, k.lastCount);
+
+    k.messages = 0;
+    k.wordCount = 0;
+    lo.setFrequency(1420.0);
+    TEST_ASSERT_EQUAL(1, k.messages);
+    TEST_ASSERT_EQUAL(k.wordCount, k.lastCount);
+    TEST_ASSERT_EQUAL_HEX32(lo.Curr.Reg[0], k.words[k.wordCount - 1]);     // MSB-first bytes
+    for (int i = 0; i < k.lastCount; i++) {
+        TEST_ASSERT_EQUAL(i + 1 < k.lastCount ? 1 : 0, k.lastCsChange[i]);  // LE edge per word
+    }
+    TEST_ASSERT_EQUAL_UINT32(20000000UL, k.speedHz);
+}
+
+void test_long_batches_are_split(void) {
+    resetKernel();
+    LinuxSpidevHAL hal(fakeOps);
+    hal.attach(SPI_FD);
+    uint32_t words[10];
+    for (int i = 0; i < 10; i++) words[i] = 0x11110000UL + i;
+    hal.spiWriteRegisters(words, 10);
+    TEST_ASSERT_EQUAL(2, k.messages);
+    TEST_ASSERT_EQUAL(10 - LinuxSpidevHAL::MAX_BATCH, k.lastCount);
+    TEST_ASSERT_EQUAL_HEX32_ARRAY(words, k.words, 10);
+}
+
+void test_attach_releases_held_descriptors(void) {
+    resetKernel();
+    {
+        LinuxSpidevHAL hal(fakeOps);
+        TEST_ASSERT_TRUE(hal.begin("/dev/spidev0.0", 10000000UL, "/dev/gpiochip0", 25, 24));
+        TEST_ASSERT_EQUAL(1, k.closes);
+        hal.attach(SPI_FD + 1, LINE_FD_BASE + 1);
+        TEST_ASSERT_EQUAL(4, k.closes);                 // spidev, CE and MUXOUT from begin()
+    }
+    TEST_ASSERT_EQUAL(6, k.closes);                     // attached fds are owned by the HAL
+}
+
+void test_stand_in_device_nodes(void) {
+    LinuxSpidevHAL hal;                                 // real system calls
+    TEST_ASSERT_FALSE(hal.begin("/nonexistent/spidev9.9"));
+    TEST_ASSERT_FALSE(hal.begin("/dev/null"));          // opens, but is not a spidev
+    hal.attach(-1);
+    hal.spiWriteRegister(0x00400005UL);
+    TEST_ASSERT_EQUAL(1, hal.errors());
+    TEST_ASSERT_FALSE(hal.readMuxout());
+}
+
+void test_delay_uses_monotonic_clock(void) {
+    LinuxSpidevHAL hal(fakeOps);
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    hal.delayMs(20);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    long elapsedUs = (t1.tv_sec - t0.tv_sec) * 1000000L + (t1.tv_nsec - t0.tv_nsec) / 1000;
+    TEST_ASSERT_TRUE(elapsedUs >= 20000);
+}
+
+void runAllTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_begin_configures_spi_and_lines);
+    RUN_TEST(test_one_message_per_update);
+    RUN_TEST(test_long_batches_are_split);
+    RUN_TEST(test_attach_releases_held_descriptors);
+    RUN_TEST(test_stand_in_device_nodes);
+    RUN_TEST(test_delay_uses_monotonic_clock);
+    UNITY_END();
+}
+
+#else
+void runAllTests(void) {
+    UNITY_BEGIN();                                      // spidev is Linux only
+    UNITY_END();
+}
+#endif
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    delay(2000);
+    runAllTests();
+}
+void loop() { delay(1000); }
+#else
+int main(void) {
+    runAllTests();
+    return 0;
+}
+#endif
@@ -0,0 +1,174 @@
+#ifdef ARDUINO
+  #include <Arduino.h>
+#endif
+#include <unity.h>
+#include "max2871.h"
+#include "max2871_stream.h"
+#include "mcu_hal.h"
+#include "max2871_transport.h"
+
+using namespace max2871stream;
+
+// ---- Host: a driver whose writes are captured per point ----
+
+class PointRecorder : public IDelayProvider, public I_MAX2871Transport {
+public:
+    uint32_t words[12];
+    uint8_t count = 0;
+
+    void delayMs(uint32_t) override {}
+    bool readMuxout() override { return true; }
+    void spiWriteRegister(uint32_t value) override {
+        if (count < sizeof(words) / sizeof(words[0])) words[count++] = value;
+    }
+};
+
+// ---- Device: what the decoder sends, batch by batch ----
+
+class BatchLog : public I_MAX2871Transport {
+public:
+    uint32_t chip[6];                   // last word latched per register
+    uint32_t log[64];                   // every word, in order (first 64)
+    uint32_t words = 0;
+    uint32_t batches = 0;
+
+    bool readMuxout() override { return true; }
+    void spiWriteRegister(uint32_t value) override {
+        chip[value & 0x7] = value;
+        if (words < 64) log[words] = value;
+        words++;
+    }
+    void spiWriteRegisters(const uint32_t* values, uint8_t n) override {
+        batches++;
+        for (uint8_t i = 0; i < n; i++) spiWriteRegister(values[i]);
+    }
+};
+
+#ifdef ARDUINO
+static const int POINTS = 200;
+#else
+static const int POINTS = 2000;
+#endif
+
+static uint8_t buf[POINTS * 6];
+static PointRecorder rec;
+static MAX2871 host(66.0, rec, rec);
+
+static uint16_t hookCalls;
+static void countPoint(uint16_t, void*) { hookCalls++; }
+
+void setUp(void) {
+    host.begin();
+    hookCalls = 0;
+}
+
+void tearDown(void) {}
+
+void test_solver_sweep_round_trip(void) {
+    // Solver-chosen points (M changes often): the device must replay exactly the host's writes
+    Encoder enc(buf, sizeof(buf));
+    host.setFrequency(1000.0);
+    TEST_ASSERT_TRUE(enc.keyframe(host.Curr.Reg));
+    uint32_t hostWords = 6;
+    uint32_t first[58];                                     // after the keyframe in dev.log
+    uint32_t logged = 0;
+    for (int i = 1; i < POINTS; i++) {
+        rec.count = 0;
+        host.setFrequency(1000.0 + 0.1 * i);
+        hostWords += rec.count;
+        for (uint8_t k = 0; k < rec.count && logged < 58; k++) first[logged++] = rec.words[k];
+        TEST_ASSERT_TRUE(enc.point(rec.words, rec.count));
+    }
+    TEST_ASSERT_TRUE(enc.finish());
+    TEST_ASSERT_EQUAL(POINTS, enc.points());
+
+    BatchLog dev;
+    Decoder dec(dev);
+    uint32_t zero[6] = {0, 1, 2, 3, 4, 5};
+    dec.begin(zero);
+    dec.setPointHook(countPoint, nullptr);
+    TEST_ASSERT_EQUAL(POINTS, dec.feed(buf, enc.size()));
+    TEST_ASSERT_EQUAL(POINTS, hookCalls);
+    TEST_ASSERT_EQUAL(hostWords, dev.words);
+    TEST_ASSERT_EQUAL_HEX32_ARRAY(first, dev.log + 6, logged);
+    TEST_ASSERT_EQUAL_HEX32_ARRAY(host.Curr.Reg, dev.chip, 6);
+
+    // M moves with nearly every point here, yet each word costs under 3 bytes instead of 4
+    TEST_ASSERT_TRUE(enc.size() < hostWords * 3);
+}
+
+void test_fixed_m_sweep_is_run_length_encoded(void) {
+    Encoder enc(buf, sizeof(buf));
+    const uint32_t M = 4000UL << 8, N = 46;                 // Fpfd / 4000 = 16.5 kHz VCO steps
+    host.setFrequency((1UL << 20) | M | N, 1);
+    TEST_ASSERT_TRUE(enc.keyframe(host.Curr.Reg));
+    for (int i = 1; i < POINTS; i++) {
+        rec.count = 0;
+        host.setFrequency(((1UL + i) << 20) | M | N, 1);
+        TEST_ASSERT_TRUE(enc.point(rec.words, rec.count));
+    }
+    TEST_ASSERT_TRUE(enc.finish());
+    TEST_ASSERT_TRUE(enc.size() * 4 < (size_t)POINTS);      // well under a byte per point
+
+    BatchLog dev;
+    Decoder dec(dev);
+    uint32_t zero[6] = {0, 1, 2, 3, 4, 5};
+    dec.begin(zero);
+    TEST_ASSERT_EQUAL(POINTS, dec.feed(buf, enc.size()));
+    TEST_ASSERT_EQUAL(POINTS, dev.batches);                 // one transport call per point
+    TEST_ASSERT_EQUAL_HEX32_ARRAY(host.Curr.Reg, dev.chip, 6);
+}
+
+void test_record_lengths(void) {
+    const uint8_t delta[] = {0x03, 0x71, 0xAA, 0xBB, 0xCC, 0xDD};   // R1: 1 byte, R0: 3 bytes
+    const uint8_t run[] = {0x85, 0x00, 0x03, 0x00};
+    TEST_ASSERT_EQUAL(6, recordLength(delta, sizeof(delta)));
+    TEST_ASSERT_EQUAL(0, recordLength(delta, 5));
+    TEST_ASSERT_EQUAL(4, recordLength(run, sizeof(run)));
+    const uint8_t abs2[9] = {0x41 | 0x04};
+    TEST_ASSERT_EQUAL(9, recordLength(abs2, 9));
+}
+
+void test_bad_input_is_rejected(void) {
+    uint32_t words[2] = {host.Curr.Reg[0], host.Curr.Reg[1]};
+    Encoder enc(buf, sizeof(buf));
+    TEST_ASSERT_FALSE(enc.point(words, 1));                 // no keyframe yet
+    TEST_ASSERT_TRUE(enc.keyframe(host.Curr.Reg));
+    TEST_ASSERT_FALSE(enc.point(words, 2));                 // R0 before R1
+    Encoder tiny(buf, 8);
+    TEST_ASSERT_FALSE(tiny.keyframe(host.Curr.Reg));
+    TEST_ASSERT_EQUAL(0, tiny.size());
+
+    BatchLog dev;
+    Decoder dec(dev);
+    dec.begin(host.Curr.Reg);
+    const uint8_t touchesAddress[] = {0x01, 0x01, 0x07};    // XOR into R0 bits [2:0]
+    TEST_ASSERT_EQUAL(-1, dec.feed(touchesAddress, sizeof(touchesAddress)));
+    const uint8_t truncated[] = {0x01, 0x03, 0x08};
+    TEST_ASSERT_EQUAL(-1, dec.feed(truncated, sizeof(truncated)));
+    TEST_ASSERT_EQUAL(0, dev.words);
+    TEST_ASSERT_EQUAL_HEX32_ARRAY(host.Curr.Reg, dec.image(), 6);
+}
+
+void runAllTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_solver_sweep_round_trip);
+    RUN_TEST(test_fixed_m_sweep_is_run_length_encoded);
+    RUN_TEST(test_record_lengths);
+    RUN_TEST(test_bad_input_is_rejected);
+    UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    delay(2000);
+    runAllTests();
+}
+void loop() { delay(1000); }
+#else
+int main(void) {
+    runAllTests();
+    return 0;
+}
+#endif
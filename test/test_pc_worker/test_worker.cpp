@@ -0,0 +1,198 @@
+#ifdef ARDUINO
+  #include <Arduino.h>
+#endif
+#include <unity.h>
+#include "max2871.h"
+#include "max2871_worker.h"
+#include "mcu_hal.h"
+
+#if MAX2871_HAS_WORKER
+
+#if !defined(ARDUINO)
+  #include <thread>
+  #include <chrono>
+  #include <stdio.h>
+#endif
+
+// ---- Bus stand-in: keeps what each register latched and every word in order ----
+
+class WordLog : public I_MAX2871Transport, public IDelayProvider {
+public:
+    uint32_t chip[6];
+    uint32_t words = 0;
+    uint32_t batches = 0;
+    uint32_t hash = 0;                  // order-sensitive digest of every word
+
+    void delayMs(uint32_t) override {}
+    bool readMuxout() override { return true; }
+    void spiWriteRegister(uint32_t value) override {
+        chip[value & 0x7] = value;
+        words++;
+        hash = (hash ^ value) * 16777619UL;
+    }
+    void spiWriteRegisters(const uint32_t* values, uint8_t n) override {
+        batches++;
+        for (uint8_t i = 0; i < n; i++) spiWriteRegister(values[i]);
+    }
+};
+
+static double point(uint32_t i) {
+    // Mostly small steps with a few octave and band jumps mixed in
+    if (i % 97 == 0) return 700.0 + (i % 5) * 0.125;
+    return 1000.0 + 0.37 * (i % 4000) + ((i / 4000) % 3) * 1200.0;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_fifo_wraps_and_reports_full(void) {
+    SpscFifo<uint32_t, 4> q;
+    uint32_t v = 0;
+    TEST_ASSERT_EQUAL(3, q.capacity());
+    TEST_ASSERT_FALSE(q.pop(v));
+    for (uint32_t round = 0; round < 5; round++) {
+        for (uint32_t i = 0; i < 3; i++) TEST_ASSERT_TRUE(q.push(round * 10 + i));
+        TEST_ASSERT_FALSE(q.push(99));
+        for (uint32_t i = 0; i < 3; i++) {
+            TEST_ASSERT_TRUE(q.pop(v));
+            TEST_ASSERT_EQUAL_UINT32(round * 10 + i, v);
+        }
+        TEST_ASSERT_TRUE(q.empty());
+    }
+}
+
+void test_results_match_setFrequency(void) {
+    WordLog direct, split;
+    MAX2871 ref(66.0, direct, direct);
+    MAX2871 lo(66.0, split, split);
+    ref.begin();
+    lo.begin();
+    MAX2871SolverWorker worker(66.0);
+    TEST_ASSERT_FALSE(worker.service());                   // nothing before begin()
+    TEST_ASSERT_TRUE(worker.begin(lo.Curr));
+    direct.words = split.words = 0;
+
+    for (uint32_t i = 0; i < 300; i++) {
+        ref.setFrequency(point(i));
+        TEST_ASSERT_TRUE(worker.request(point(i), i));
+        TEST_ASSERT_TRUE(worker.service());
+        uint32_t tag = 0xFFFF;
+        TEST_ASSERT_TRUE(worker.commit(lo, &tag));
+        TEST_ASSERT_EQUAL_UINT32(i, tag);
+    }
+    TEST_ASSERT_EQUAL(direct.words, split.words);
+    TEST_ASSERT_EQUAL_HEX32(direct.hash, split.hash);
+    TEST_ASSERT_EQUAL_HEX32_ARRAY(ref.Curr.Reg, lo.Curr.Reg, 6);
+    TEST_ASSERT_EQUAL_UINT16(ref.N, lo.N);
+    TEST_ASSERT_EQUAL(0, worker.outstanding());
+}
+
+void test_full_result_queue_holds_the_solve(void) {
+    WordLog bus;
+    MAX2871 lo(66.0, bus, bus);
+    lo.begin();
+    MAX2871SolverWorker worker(66.0);
+    worker.begin(lo.Curr);
+    const uint8_t cap = MAX2871_WORKER_QUEUE - 1;
+    for (uint8_t i = 0; i < cap; i++) TEST_ASSERT_TRUE(worker.request(2000.0 + i, i));
+    TEST_ASSERT_FALSE(worker.request(1.0));
+    for (uint8_t i = 0; i < cap; i++) worker.service();
+    for (uint8_t i = 0; i < cap; i++) TEST_ASSERT_TRUE(worker.request(3000.0 + i, cap + i));
+    TEST_ASSERT_TRUE(worker.service());                     // solved, held: results are full
+    TEST_ASSERT_TRUE(worker.service());                     // still held, nothing lost
+    uint32_t tag, expect = 0;
+    while (worker.outstanding()) {
+        worker.service();
+        if (worker.commit(lo, &tag)) TEST_ASSERT_EQUAL_UINT32(expect++, tag);
+    }
+    TEST_ASSERT_EQUAL(2 * cap, expect);
+    MAX2871 ref(66.0, bus, bus);
+    ref.freq2FMN(3000.0 + cap - 1);
+    TEST_ASSERT_EQUAL_UINT16(ref.N, lo.N);
+    TEST_ASSERT_EQUAL_UINT32(ref.Frac, lo.Frac);
+}
+
+#if !defined(ARDUINO)
+void test_two_threads_sweep(void) {
+    static const uint32_t POINTS = 20000;
+    WordLog direct, split;
+    MAX2871 ref(66.0, direct, direct);
+    MAX2871 lo(66.0, split, split);
+    ref.begin();
+    lo.begin();
+    direct.words = split.words = 0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < POINTS; i++) ref.setFrequency(point(i));
+    auto t1 = std::chrono::steady_clock::now();
+
+    MAX2871SolverWorker worker(66.0);
+    worker.begin(lo.Curr);
+    std::atomic<bool> stop(false);
+    std::thread core1([&] {
+        while (!stop.load()) {
+            if (!worker.service()) std::this_thread::yield();
+        }
+    });
+    uint32_t sent = 0, committed = 0, tag;
+    bool inOrder = true;
+    auto t2 = std::chrono::steady_clock::now();
+    while (committed < POINTS) {
+        while (sent < POINTS && worker.request(point(sent), sent)) sent++;
+        if (worker.commit(lo, &tag)) inOrder = inOrder && tag == committed++;
+        else std::this_thread::yield();                     // lets the worker run on one CPU too
+    }
+    auto t3 = std::chrono::steady_clock::now();
+    stop.store(true);
+    core1.join();
+
+    TEST_ASSERT_TRUE(inOrder);
+    TEST_ASSERT_EQUAL(direct.words, split.words);
+    TEST_ASSERT_EQUAL_HEX32(direct.hash, split.hash);
+    TEST_ASSERT_EQUAL_HEX32_ARRAY(ref.Curr.Reg, lo.Curr.Reg, 6);
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "one thread %.0f ns/point, split %.0f ns/point, %u CPUs",
+             std::chrono::duration<double, std::nano>(t1 - t0).count() / POINTS,
+             std::chrono::duration<double, std::nano>(t3 - t2).count() / POINTS,
+             std::thread::hardware_concurrency());
+    TEST_MESSAGE(msg);
+}
+#endif
+
+void runAllTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_fifo_wraps_and_reports_full);
+    RUN_TEST(test_results_match_setFrequency);
+    RUN_TEST(test_full_result_queue_holds_the_solve);
+#if !defined(ARDUINO)
+    RUN_TEST(test_two_threads_sweep);
+#endif
+    UNITY_END();
+}
+
+#else   // no worker on this target
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void runAllTests(void) {
+    UNITY_BEGIN();
+    UNITY_END();
+}
+
+#endif
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    delay(2000);
+    runAllTests();
+}
+void loop() { delay(1000); }
+#else
+int main(void) {
+    runAllTests();
+    return 0;
+}
+#endif